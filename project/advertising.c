@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * @file advertising.c
+ * @brief Adaptive advertising scheduler
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "advertising.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "logging.h"
+
+#define ALL_CHANNELS 7
+#define ADVERTISING_SET 0
+#define REPORT_SCAN_REQUESTS 1
+
+static const AdvertisingStage stages[] = ADVERTISING_STAGES;
+#define NUMBER_OF_STAGES (sizeof(stages) / sizeof(stages[0]))
+
+static uint8 stage;
+static bool active;
+
+static bool highDuty;
+
+static void startAdvertising(uint16 interval) {
+	/* The parameters only apply when advertising starts, so stop first */
+	gecko_cmd_le_gap_set_mode(le_gap_non_discoverable, le_gap_non_connectable);
+	/* Scan requests are reported so the scan response can be built on demand */
+	gecko_cmd_le_gap_bt5_set_adv_parameters(ADVERTISING_SET, interval, interval, ALL_CHANNELS, REPORT_SCAN_REQUESTS);
+	/* Advertising data is provided by the broadcast module */
+	gecko_cmd_le_gap_set_mode(le_gap_user_data, le_gap_undirected_connectable);
+	active = true;
+}
+
+static void enterStage(uint8 newStage) {
+	const AdvertisingStage *s = &stages[newStage];
+	stage = newStage;
+	highDuty = false;
+	LogInfo("Advertising stage %d, interval %d", newStage, s->interval);
+	startAdvertising(s->interval);
+	/* Timed rather than counted in advertising events, which are spread by the random advDelay */
+	gecko_cmd_hardware_set_soft_timer(s->duration ? (uint32)(((uint64_t) s->duration * TIMER_CLK_FREQ) / 1000) : TIMER_STOP,
+			AppTimerIDAdvertising, true);
+}
+
+void advertising_Start(void) {
+	enterStage(0);
+}
+
+void advertising_StartHighDuty(void) {
+	gecko_cmd_hardware_set_soft_timer(TIMER_STOP, AppTimerIDAdvertising, true);
+	highDuty = true;
+	LogInfo("High duty advertising");
+	startAdvertising(ADVERTISING_HIGH_DUTY_INTERVAL);
+}
+
+void advertising_UserActivity(void) {
+	if (active && !highDuty) {
+		enterStage(0);
+	}
+}
+
+void advertising_ConnectionOpened(void) {
+	active = false;
+	gecko_cmd_hardware_set_soft_timer(TIMER_STOP, AppTimerIDAdvertising, true);
+}
+
+void advertising_Timeout(void) {
+	if (!active || highDuty) {
+		return;
+	}
+	if (stage + 1 < NUMBER_OF_STAGES) {
+		enterStage(stage + 1);
+	}
+}
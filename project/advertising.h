@@ -0,0 +1,102 @@
+/*****************************************************************************
+ * @file advertising.h
+ * @brief Adaptive advertising scheduler
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef ADVERTISING_H_
+#define ADVERTISING_H_
+
+#include "bg_types.h"
+
+/* Advertising starts with a fast burst and steps down through slower
+ * intervals the longer nobody connects. Each stage is timed with the
+ * AppTimerIDAdvertising soft timer, which moves the scheduler on to the next
+ * stage. The last stage runs until a connection is made or the burst restarts.
+ */
+
+/** A stage of the advertising schedule. */
+typedef struct {
+	/** Advertising interval in units of 0.625ms */
+	uint16 interval;
+	/** How long to stay in this stage in ms, 0 to stay forever */
+	uint32 duration;
+} AdvertisingStage;
+
+/** The advertising schedule. Override by defining ADVERTISING_STAGES as an initialiser list. */
+#ifndef ADVERTISING_STAGES
+#define ADVERTISING_STAGES { \
+	{ 32, 30000 },   /* 20ms for 30s */ \
+	{ 244, 60000 },  /* 152.5ms for 1 minute */ \
+	{ 668, 300000 }, /* 417.5ms for 5 minutes */ \
+	{ 1636, 0 },     /* 1022.5ms until connected */ \
+}
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Start advertising from the first stage of the schedule.
+ *
+ * @note
+ *   Call after boot and after a connection closes.
+ ******************************************************************************/
+void advertising_Start(void);
+
+/** Interval used by advertising_StartHighDuty(), in units of 0.625ms. */
+#ifndef ADVERTISING_HIGH_DUTY_INTERVAL
+#define ADVERTISING_HIGH_DUTY_INTERVAL 32
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Advertise at the shortest interval until a connection is made or
+ *   advertising_Start() is called, ignoring the schedule.
+ ******************************************************************************/
+void advertising_StartHighDuty(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Restart the fast burst if the device is advertising, e.g. on a button press.
+ ******************************************************************************/
+void advertising_UserActivity(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Mark advertising as stopped because a connection was opened.
+ ******************************************************************************/
+void advertising_ConnectionOpened(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Move on to the next stage. Call when the AppTimerIDAdvertising timer fires.
+ ******************************************************************************/
+void advertising_Timeout(void);
+
+#endif /* ADVERTISING_H_ */
@@ -0,0 +1,228 @@
+/*****************************************************************************
+ * @file aes_ccm.c
+ * @brief AES-128 CCM on the CRYPTO peripheral
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "aes_ccm.h"
+#include "util.h"
+#include <string.h>
+#include "em_device.h"
+#include "em_core.h"
+#include "em_crypto.h"
+#include "logging.h"
+
+#define BLOCK_LENGTH 16
+#define CHUNK_LENGTH (AES_CCM_CHUNK_BLOCKS * BLOCK_LENGTH)
+/* Bytes of the length field, L in RFC 3610 */
+#define LENGTH_FIELD 2
+#define FLAG_ADATA 0x40
+
+/* CBC-MAC over a byte stream, in whole blocks on the peripheral */
+typedef struct {
+	const uint8 *key;
+	uint8 mac[BLOCK_LENGTH];
+	uint8 block[BLOCK_LENGTH];
+	uint8 fill;
+} MacState;
+
+static void macBlocks(MacState *state, const uint8 *data, uint32 len) {
+	uint8 out[CHUNK_LENGTH];
+	while (len > 0) {
+		uint32 n = MIN(len, CHUNK_LENGTH);
+		CORE_DECLARE_IRQ_STATE;
+		CORE_ENTER_CRITICAL();
+		CRYPTO_AES_CBC128(CRYPTO, out, data, n, state->key, state->mac, true);
+		CORE_EXIT_CRITICAL();
+		/* The last ciphertext block chains into the next call */
+		memcpy(state->mac, &out[n - BLOCK_LENGTH], BLOCK_LENGTH);
+		data += n;
+		len -= n;
+	}
+}
+
+static void macUpdate(MacState *state, const uint8 *data, uint32 len) {
+	if (state->fill > 0) {
+		uint32 n = MIN(len, (uint32)(BLOCK_LENGTH - state->fill));
+		memcpy(&state->block[state->fill], data, n);
+		state->fill += n;
+		data += n;
+		len -= n;
+		if (state->fill < BLOCK_LENGTH) {
+			return;
+		}
+		macBlocks(state, state->block, BLOCK_LENGTH);
+		state->fill = 0;
+	}
+	uint32 whole = len & ~(BLOCK_LENGTH - 1);
+	macBlocks(state, data, whole);
+	memcpy(state->block, data + whole, len - whole);
+	state->fill = len - whole;
+}
+
+/* Zero pad to a block boundary */
+static void macPad(MacState *state) {
+	if (state->fill > 0) {
+		memset(&state->block[state->fill], 0, BLOCK_LENGTH - state->fill);
+		macBlocks(state, state->block, BLOCK_LENGTH);
+		state->fill = 0;
+	}
+}
+
+static void macRecord(const uint8 *key, const AesCcmRecord *record, uint8 tagLength, uint8 *mac) {
+	MacState state = { .key = key };
+	uint8 b0[BLOCK_LENGTH];
+	b0[0] = (record->aadLen ? FLAG_ADATA : 0) | (((tagLength - 2) / 2) << 3) | (LENGTH_FIELD - 1);
+	memcpy(&b0[1], record->nonce, AES_CCM_NONCE_LENGTH);
+	b0[14] = record->len >> 8;
+	b0[15] = record->len & 0xFF;
+	memset(state.mac, 0, BLOCK_LENGTH);
+	macUpdate(&state, b0, BLOCK_LENGTH);
+	if (record->aadLen) {
+		const uint8 aadLength[2] = { record->aadLen >> 8, record->aadLen & 0xFF };
+		macUpdate(&state, aadLength, sizeof(aadLength));
+		macUpdate(&state, record->aad, record->aadLen);
+		macPad(&state);
+	}
+	macUpdate(&state, record->data, record->len);
+	macPad(&state);
+	memcpy(mac, state.mac, BLOCK_LENGTH);
+}
+
+static void counterBlock(uint8 *ctr, const uint8 *nonce, uint16 counter) {
+	ctr[0] = LENGTH_FIELD - 1;
+	memcpy(&ctr[1], nonce, AES_CCM_NONCE_LENGTH);
+	ctr[14] = counter >> 8;
+	ctr[15] = counter & 0xFF;
+}
+
+/* Counter mode from counter 1, in place. Encryption and decryption are the same. */
+static void ctrRecord(const uint8 *key, const AesCcmRecord *record) {
+	uint8 ctr[BLOCK_LENGTH];
+	counterBlock(ctr, record->nonce, 1);
+	uint8 *data = record->data;
+	uint32 len = record->len;
+	while (len >= BLOCK_LENGTH) {
+		uint32 whole = len & ~(BLOCK_LENGTH - 1);
+		uint32 n = MIN(whole, CHUNK_LENGTH);
+		CORE_DECLARE_IRQ_STATE;
+		CORE_ENTER_CRITICAL();
+		CRYPTO_AES_CTR128(CRYPTO, data, data, n, key, ctr, CRYPTO_AES_CTRUpdate32Bit);
+		CORE_EXIT_CRITICAL();
+		data += n;
+		len -= n;
+	}
+	if (len > 0) {
+		uint8 block[BLOCK_LENGTH];
+		memcpy(block, data, len);
+		memset(&block[len], 0, BLOCK_LENGTH - len);
+		CORE_DECLARE_IRQ_STATE;
+		CORE_ENTER_CRITICAL();
+		CRYPTO_AES_CTR128(CRYPTO, block, block, BLOCK_LENGTH, key, ctr, CRYPTO_AES_CTRUpdate32Bit);
+		CORE_EXIT_CRITICAL();
+		memcpy(data, block, len);
+	}
+}
+
+/* The tag is the CBC-MAC masked with the encryption of counter 0 */
+static void maskTag(const uint8 *key, const uint8 *nonce, uint8 *mac) {
+	uint8 s0[BLOCK_LENGTH];
+	counterBlock(s0, nonce, 0);
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	CRYPTO_AES_ECB128(CRYPTO, s0, s0, BLOCK_LENGTH, key, true);
+	CORE_EXIT_CRITICAL();
+	for (int i = 0; i < BLOCK_LENGTH; i++) {
+		mac[i] ^= s0[i];
+	}
+}
+
+void aesCcm_EncryptBatch(const uint8 *key, AesCcmRecord *records, uint8 count, uint8 tagLength) {
+	uint8 mac[BLOCK_LENGTH];
+	for (uint8 i = 0; i < count; i++) {
+		AesCcmRecord *record = &records[i];
+		macRecord(key, record, tagLength, mac);
+		ctrRecord(key, record);
+		maskTag(key, record->nonce, mac);
+		memcpy(record->tag, mac, tagLength);
+	}
+}
+
+void aesCcm_Encrypt(const uint8 *key, AesCcmRecord *record, uint8 tagLength) {
+	aesCcm_EncryptBatch(key, record, 1, tagLength);
+}
+
+bool aesCcm_Decrypt(const uint8 *key, AesCcmRecord *record, uint8 tagLength) {
+	uint8 mac[BLOCK_LENGTH];
+	ctrRecord(key, record);
+	macRecord(key, record, tagLength, mac);
+	maskTag(key, record->nonce, mac);
+	/* Compare in constant time */
+	uint8 diff = 0;
+	for (uint8 i = 0; i < tagLength; i++) {
+		diff |= mac[i] ^ record->tag[i];
+	}
+	if (diff) {
+		memset(record->data, 0, record->len);
+		return false;
+	}
+	return true;
+}
+
+bool aesCcm_Init(void) {
+	/* RFC 3610 packet vector #1 */
+	static const uint8 key[AES_CCM_KEY_LENGTH] = {
+		0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8, 0xC9, 0xCA, 0xCB, 0xCC, 0xCD, 0xCE, 0xCF,
+	};
+	static const uint8 nonce[AES_CCM_NONCE_LENGTH] = {
+		0x00, 0x00, 0x00, 0x03, 0x02, 0x01, 0x00, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xA5,
+	};
+	static const uint8 expected[31] = {
+		0x58, 0x8C, 0x97, 0x9A, 0x61, 0xC6, 0x63, 0xD2, 0xF0, 0x66, 0xD0, 0xC2, 0xC0, 0xF9, 0x89, 0x80,
+		0x6D, 0x5F, 0x6B, 0x61, 0xDA, 0xC3, 0x84, 0x17, 0xE8, 0xD1, 0x2C, 0xFD, 0xF9, 0x26, 0xE0,
+	};
+	uint8 aad[8];
+	uint8 data[23];
+	uint8 tag[8];
+	for (uint8 i = 0; i < sizeof(aad); i++) {
+		aad[i] = i;
+	}
+	for (uint8 i = 0; i < sizeof(data); i++) {
+		data[i] = sizeof(aad) + i;
+	}
+	AesCcmRecord record = { data, sizeof(data), aad, sizeof(aad), nonce, tag };
+	aesCcm_Encrypt(key, &record, sizeof(tag));
+	bool ok = memcmp(data, expected, sizeof(data)) == 0 && memcmp(tag, &expected[sizeof(data)], sizeof(tag)) == 0;
+	ok = ok && aesCcm_Decrypt(key, &record, sizeof(tag)) && data[0] == sizeof(aad);
+	if (!ok) {
+		LogWarn("AES-CCM self test failed");
+	}
+	return ok;
+}
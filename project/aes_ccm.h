@@ -0,0 +1,124 @@
+/*****************************************************************************
+ * @file aes_ccm.h
+ * @brief AES-128 CCM on the CRYPTO peripheral
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef AES_CCM_H_
+#define AES_CCM_H_
+
+#include "bg_types.h"
+
+/* AES-128 in CCM mode (RFC 3610, NIST SP 800-38C) with a 13 byte nonce and
+ * a two byte length field, so each record carries up to 65535 bytes. The
+ * CBC-MAC, the counter mode keystream and the tag mask are all computed by
+ * the CRYPTO peripheral; data is encrypted and decrypted in place.
+ *
+ * The Bluetooth stack uses the CRYPTO peripheral for link layer encryption,
+ * so it is only held inside a critical section for AES_CCM_CHUNK_BLOCKS
+ * blocks at a time, which bounds the interrupt latency added.
+ *
+ * tools/aes_ccm.py is the host reference.
+ */
+
+#define AES_CCM_KEY_LENGTH 16
+#define AES_CCM_NONCE_LENGTH 13
+#define AES_CCM_MAX_TAG_LENGTH 16
+
+/** Blocks processed per critical section. */
+#ifndef AES_CCM_CHUNK_BLOCKS
+#define AES_CCM_CHUNK_BLOCKS 4
+#endif
+
+typedef struct {
+	/** Plaintext, replaced by the ciphertext */
+	uint8 *data;
+	uint16 len;
+	/** Additional data that is authenticated but not encrypted, may be NULL */
+	const uint8 *aad;
+	uint16 aadLen;
+	/** AES_CCM_NONCE_LENGTH bytes, which must never repeat for the same key */
+	const uint8 *nonce;
+	/** Receives the authentication tag */
+	uint8 *tag;
+} AesCcmRecord;
+
+/***************************************************************************//**
+ * @brief
+ *   Check the peripheral against a known answer. Call once after the clocks are enabled.
+ *
+ * @return
+ *   True if the peripheral produced the RFC 3610 test vector.
+ ******************************************************************************/
+bool aesCcm_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Encrypt and authenticate several records with the same key.
+ *
+ * @param[in] key
+ *   AES_CCM_KEY_LENGTH byte key.
+ *
+ * @param[in,out] records
+ *   The records. Each record's data is encrypted in place and its tag written.
+ *
+ * @param[in] count
+ *   Number of records.
+ *
+ * @param[in] tagLength
+ *   Tag length in bytes: 4, 6, 8, 10, 12, 14 or 16.
+ ******************************************************************************/
+void aesCcm_EncryptBatch(const uint8 *key, AesCcmRecord *records, uint8 count, uint8 tagLength);
+
+/***************************************************************************//**
+ * @brief
+ *   Encrypt and authenticate a single record. See aesCcm_EncryptBatch().
+ ******************************************************************************/
+void aesCcm_Encrypt(const uint8 *key, AesCcmRecord *record, uint8 tagLength);
+
+/***************************************************************************//**
+ * @brief
+ *   Decrypt and verify a record in place.
+ *
+ * @param[in] key
+ *   AES_CCM_KEY_LENGTH byte key.
+ *
+ * @param[in,out] record
+ *   The record. Its data is decrypted in place and its tag checked.
+ *
+ * @param[in] tagLength
+ *   Tag length in bytes.
+ *
+ * @return
+ *   True if the tag matched. On failure the data is cleared.
+ ******************************************************************************/
+bool aesCcm_Decrypt(const uint8 *key, AesCcmRecord *record, uint8 tagLength);
+
+#endif /* AES_CCM_H_ */
@@ -16,6 +16,8 @@
 extern "C" {
 #endif
 
+#include "native_gecko.h"
+
 /***********************************************************************************************//**
  * @addtogroup Application
  * @{
@@ -34,9 +36,17 @@ extern "C" {
 #define TIMER_CLK_FREQ ((uint32)32768)
 /** Convert msec to timer ticks. */
 #define TIMER_MS_2_TIMERTICK(ms) ((TIMER_CLK_FREQ * ms) / 1000)
+/** Convert timer ticks to msec. */
+#define TIMER_TIMERTICK_2_MS(ticks) ((uint32)(((uint64_t)(ticks) * 1000) / TIMER_CLK_FREQ))
 /** Stop timer. */
 #define TIMER_STOP 0
 
+/** Current time in timer ticks since reset. Wraps after ~36 hours, so only use for differences. */
+static inline uint32 appTimerNow(void) {
+	struct gecko_msg_hardware_get_time_rsp_t *rsp = gecko_cmd_hardware_get_time();
+	return rsp->seconds * TIMER_CLK_FREQ + rsp->ticks;
+}
+
 /** Application timer enumeration. */
 typedef enum {
 	AppTimerIDStop = 0,
@@ -49,6 +59,36 @@ typedef enum {
 	     within the Sharp memory LCD panel */
 	AppTimerIDDispPolInv,
 #endif
+	/** Throughput pump timer.
+	 *  Retries sending the stream buffer after the stack ran out of buffers */
+	AppTimerIDThroughputPump,
+	/** Observer age timer.
+	 *  Ages out advertisers that have not been heard recently */
+	AppTimerIDObserverAge,
+	/** Reconnect timer.
+	 *  Ends reconnection advertising to the last peer */
+	AppTimerIDReconnect,
+	/** Upgrade timer.
+	 *  Polls the SPI flash while an upgrade image is programmed and verified */
+	AppTimerIDUpgrade,
+	/** Hibernate timer.
+	 *  Enters EM4 after a long time without activity */
+	AppTimerIDHibernate,
+	/** Event log timer.
+	 *  Polls the SPI flash while log pages are programmed and sectors erased */
+	AppTimerIDEventLog,
+	/** Persist timer.
+	 *  Writes changed values to their PS keys in one pass */
+	AppTimerIDPersist,
+	/** Coroutine timer.
+	 *  Wakes sleeping coroutines, see coroutine.h */
+	AppTimerIDCoroutine,
+	/** Pairing timer.
+	 *  Ends the window in which new bonds are accepted */
+	AppTimerIDPairing,
+	/** Advertising timer.
+	 *  Moves advertising on to the next, slower stage */
+	AppTimerIDAdvertising,
 } AppTimerID;
 
 /** @} (end addtogroup app) */
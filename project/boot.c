@@ -0,0 +1,156 @@
+/*****************************************************************************
+ * @file boot.c
+ * @brief Boot stage timing and deferred initialisation
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "boot.h"
+#include "em_device.h"
+#include "em_cmu.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "work.h"
+#include "logging.h"
+
+typedef struct {
+	BootTask task;
+	const char *name;
+} DeferredTask;
+
+static const char * const stageNames[BootStageCount] = { "reset", "device", "stack", "boot event", "discoverable", "complete" };
+
+static uint32 stageUs[BootStageCount];
+static bool warm;
+static bool complete;
+
+/* Cycle counter timing, until the stack is running */
+static uint32 lastCycles;
+static uint32 lastClock;
+static uint32 lastUs;
+/* Sleep timer timing, once the stack is running */
+static bool stackRunning;
+static uint32 stackTicks;
+
+static DeferredTask deferred[BOOT_MAX_DEFERRED];
+static uint8 deferredCount;
+static uint8 deferredNext;
+
+static void runDeferred(void);
+static WorkItem deferredWork = WORK_ITEM(runDeferred, "boot", WorkPriorityNormal);
+
+static uint32 cyclesToUs(uint32 cycles, uint32 clock) {
+	return (uint32)((uint64_t) cycles * 1000000 / clock);
+}
+
+static void report(void) {
+	LogInfo("%s boot", warm ? "Warm" : "Cold");
+	for (int i = BootStageDevice; i < BootStageCount; i++) {
+		LogInfo("  %s at %lu us", stageNames[i], stageUs[i]);
+	}
+	LogInfo("Discoverable %lu us after reset", stageUs[BootStageDiscoverable]);
+}
+
+void boot_Start(void) {
+	CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+	DWT->CYCCNT = 0;
+	DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+	lastCycles = 0;
+	lastClock = SystemCoreClockGet();
+	lastUs = 0;
+	stageUs[BootStageReset] = 0;
+}
+
+void boot_Mark(BootStage stage) {
+	if (stage >= BootStageCount) {
+		return;
+	}
+	uint32 us;
+	if (stackRunning) {
+		us = lastUs + (uint32)((uint64_t)(appTimerNow() - stackTicks) * 1000000 / TIMER_CLK_FREQ);
+	} else {
+		uint32 cycles = DWT->CYCCNT;
+		us = lastUs + cyclesToUs(cycles - lastCycles, lastClock);
+		lastCycles = cycles;
+		/* The clock may have changed in this stage */
+		lastClock = SystemCoreClockGet();
+		lastUs = us;
+		if (stage >= BootStageStack) {
+			stackRunning = true;
+			stackTicks = appTimerNow();
+		}
+	}
+	stageUs[stage] = us;
+	if (stage == BootStageComplete) {
+		report();
+	}
+}
+
+void boot_SetWarm(bool isWarm) {
+	warm = isWarm;
+}
+
+void boot_Defer(BootTask task, const char *name) {
+	if (deferredCount >= BOOT_MAX_DEFERRED) {
+		/* Better late than never */
+		LogWarn("No space to defer %s", name);
+		task();
+		return;
+	}
+	deferred[deferredCount].task = task;
+	deferred[deferredCount].name = name;
+	deferredCount++;
+	work_Post(&deferredWork);
+}
+
+/* One task per run, posting itself again for the next */
+static void runDeferred(void) {
+	if (deferredNext >= deferredCount) {
+		return;
+	}
+	DeferredTask *d = &deferred[deferredNext++];
+#if defined(LOG_LEVEL) && LOG_LEVEL > 2
+	/* Only timed when it can be logged */
+	uint32 start = DWT->CYCCNT;
+	d->task();
+	LogInfo("Deferred %s took %lu us", d->name, cyclesToUs(DWT->CYCCNT - start, SystemCoreClockGet()));
+#else
+	d->task();
+#endif
+	if (deferredNext < deferredCount) {
+		work_Post(&deferredWork);
+		return;
+	}
+	deferredCount = 0;
+	deferredNext = 0;
+	if (!complete) {
+		complete = true;
+		boot_Mark(BootStageComplete);
+	}
+}
@@ -0,0 +1,108 @@
+/*****************************************************************************
+ * @file boot.h
+ * @brief Boot stage timing and deferred initialisation
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef BOOT_H_
+#define BOOT_H_
+
+#include "bg_types.h"
+
+/* Boot is timed from the start of main() to each stage. Until the stack is
+ * running the DWT cycle counter is used, converted at the core clock in force
+ * when each interval started. From then on the stack's sleep timer is used,
+ * which keeps counting if the device sleeps.
+ *
+ * Only what is needed to be discoverable and connectable runs in the boot
+ * event. Everything else, such as the display, is queued with boot_Defer()
+ * and run one task per work queue run at normal priority (see work.h), so
+ * events received in the meantime are handled first. The stage times are
+ * logged once the last deferred task has run.
+ */
+
+/** Maximum number of deferred tasks. */
+#ifndef BOOT_MAX_DEFERRED
+#define BOOT_MAX_DEFERRED 8
+#endif
+
+typedef enum {
+	/** main() entered */
+	BootStageReset = 0,
+	/** Peripherals initialised */
+	BootStageDevice,
+	/** Stack initialised */
+	BootStageStack,
+	/** Boot event received */
+	BootStageSystemBoot,
+	/** Advertising started */
+	BootStageDiscoverable,
+	/** All deferred tasks run */
+	BootStageComplete,
+	BootStageCount,
+} BootStage;
+
+typedef void (*BootTask)(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Start the boot timer. Call first thing in main().
+ ******************************************************************************/
+void boot_Start(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Record the time a boot stage was reached.
+ ******************************************************************************/
+void boot_Mark(BootStage stage);
+
+/***************************************************************************//**
+ * @brief
+ *   Label the boot in the log.
+ *
+ * @param[in] warm
+ *   True when woken from hibernation.
+ ******************************************************************************/
+void boot_SetWarm(bool warm);
+
+/***************************************************************************//**
+ * @brief
+ *   Queue an initialisation task to run when the event loop is idle. Tasks run
+ *   in the order they are queued.
+ *
+ * @param[in] task
+ *   The task.
+ *
+ * @param[in] name
+ *   Name used in the log.
+ ******************************************************************************/
+void boot_Defer(BootTask task, const char *name);
+
+#endif /* BOOT_H_ */
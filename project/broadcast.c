@@ -0,0 +1,181 @@
+/*****************************************************************************
+ * @file broadcast.c
+ * @brief Connectionless state broadcast in advertising data
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "broadcast.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "persist.h"
+#include "logging.h"
+#if BROADCAST_ENCRYPT
+#include "telemetry.h"
+#endif
+
+#define AD_TYPE_FLAGS 0x01
+#define AD_TYPE_COMPLETE_LOCAL_NAME 0x09
+#define AD_TYPE_PUBLIC_TARGET_ADDRESS 0x17
+#define AD_TYPE_RANDOM_TARGET_ADDRESS 0x18
+#define AD_TYPE_MANUFACTURER_SPECIFIC 0xFF
+/* LE General Discoverable, BR/EDR not supported */
+#define AD_FLAGS 0x06
+#define ADV_DATA_MAX_LENGTH 31
+#define NUMBER_OF_BUTTONS 4
+#define STATE_LENGTH 3
+#define MANUFACTURER_HEADER_LENGTH 4
+
+#define ADV_DATA 0
+#define SCAN_RESPONSE 1
+
+static uint8 sequence;
+static uint8 buttons;
+static uint8 joystick = JoystickDirectionNone;
+static uint16 changeCounts[NUMBER_OF_BUTTONS];
+static bool scanResponseDirty = true;
+static bool hasTarget;
+static bd_addr target;
+static uint8 targetType;
+
+static uint8 putManufacturerHeader(uint8 *p, uint8 payloadLength) {
+	p[0] = payloadLength + 3;
+	p[1] = AD_TYPE_MANUFACTURER_SPECIFIC;
+	p[2] = BROADCAST_COMPANY_ID & 0xFF;
+	p[3] = BROADCAST_COMPANY_ID >> 8;
+	return MANUFACTURER_HEADER_LENGTH;
+}
+
+static void updateAdvData(void) {
+	uint8 data[ADV_DATA_MAX_LENGTH];
+	uint8 len = 0;
+	data[len++] = 2;
+	data[len++] = AD_TYPE_FLAGS;
+	data[len++] = AD_FLAGS;
+#if BROADCAST_ENCRYPT
+	const uint8 format = BROADCAST_FORMAT_SEALED_STATE;
+	uint8 *record = &data[len + MANUFACTURER_HEADER_LENGTH + sizeof(format)];
+	uint8 *state = &record[TELEMETRY_HEADER_LENGTH];
+	state[0] = sequence;
+	state[1] = buttons;
+	state[2] = joystick;
+	/* Left out, rather than sent in the clear, if it can't be sealed */
+	if (telemetry_Seal(record, STATE_LENGTH, &format, sizeof(format))) {
+		len += putManufacturerHeader(&data[len], 1 + STATE_LENGTH + TELEMETRY_OVERHEAD);
+		data[len++] = format;
+		len += STATE_LENGTH + TELEMETRY_OVERHEAD;
+	}
+#else
+	len += putManufacturerHeader(&data[len], 1 + STATE_LENGTH);
+	data[len++] = BROADCAST_FORMAT_STATE;
+	data[len++] = sequence;
+	data[len++] = buttons;
+	data[len++] = joystick;
+#endif
+	if (hasTarget) {
+		data[len++] = sizeof(target.addr) + 1;
+		data[len++] = targetType ? AD_TYPE_RANDOM_TARGET_ADDRESS : AD_TYPE_PUBLIC_TARGET_ADDRESS;
+		memcpy(&data[len], target.addr, sizeof(target.addr));
+		len += sizeof(target.addr);
+	}
+	uint16 result = gecko_cmd_le_gap_set_adv_data(ADV_DATA, len, data)->result;
+	if (result != bg_err_success) {
+		LogWarn("Could not set advertising data: 0x%x", result);
+	}
+}
+
+static void stateChanged(void) {
+	sequence++;
+	scanResponseDirty = true;
+	updateAdvData();
+}
+
+void broadcast_Init(void) {
+	persist_Register(BROADCAST_COUNTS_PS_KEY, changeCounts, sizeof(changeCounts), BROADCAST_COUNTS_SAVE_INTERVAL);
+	updateAdvData();
+	broadcast_ScanRequest();
+}
+
+void broadcast_SetButtonState(uint8 button, bool output) {
+	if (button >= NUMBER_OF_BUTTONS) {
+		return;
+	}
+	uint8 newButtons = output ? (buttons | (1 << button)) : (buttons & ~(1 << button));
+	if (newButtons == buttons) {
+		return;
+	}
+	buttons = newButtons;
+	changeCounts[button]++;
+	persist_Changed(BROADCAST_COUNTS_PS_KEY);
+	stateChanged();
+}
+
+void broadcast_SetJoystickDirection(JoystickDirection direction) {
+	if (direction == joystick) {
+		return;
+	}
+	joystick = direction;
+	stateChanged();
+}
+
+void broadcast_SetTargetAddress(const bd_addr *address, uint8 addressType) {
+	if (!address && !hasTarget) {
+		return;
+	}
+	hasTarget = address != NULL;
+	if (address) {
+		target = *address;
+		targetType = addressType;
+	}
+	updateAdvData();
+}
+
+void broadcast_ScanRequest(void) {
+	if (!scanResponseDirty) {
+		return;
+	}
+	uint8 data[ADV_DATA_MAX_LENGTH];
+	uint8 len = 0;
+	const uint8 nameLength = sizeof(BROADCAST_NAME) - 1;
+	data[len++] = nameLength + 1;
+	data[len++] = AD_TYPE_COMPLETE_LOCAL_NAME;
+	memcpy(&data[len], BROADCAST_NAME, nameLength);
+	len += nameLength;
+#if !BROADCAST_ENCRYPT
+	len += putManufacturerHeader(&data[len], 2 * NUMBER_OF_BUTTONS);
+	for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
+		data[len++] = changeCounts[i] & 0xFF;
+		data[len++] = changeCounts[i] >> 8;
+	}
+#endif
+	uint16 result = gecko_cmd_le_gap_set_adv_data(SCAN_RESPONSE, len, data)->result;
+	if (result == bg_err_success) {
+		scanResponseDirty = false;
+	}
+}
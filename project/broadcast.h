@@ -0,0 +1,134 @@
+/*****************************************************************************
+ * @file broadcast.h
+ * @brief Connectionless state broadcast in advertising data
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef BROADCAST_H_
+#define BROADCAST_H_
+
+#include "bg_types.h"
+#include "joystick.h"
+
+/* The panel state is broadcast in the manufacturer specific data of every
+ * advertisement, so gateways can read it by passive scanning without
+ * connecting. The advertising data is only rebuilt when the state changes.
+ *
+ * Advertising data manufacturer specific payload:
+ *   <uint16 company id> <uint8 format> <uint8 sequence> <uint8 buttons> <uint8 joystick>
+ * sequence increments on every change, buttons has bit n set when button n is
+ * an output, joystick is a JoystickDirection.
+ *
+ * The scan response carries the device name and the number of state changes
+ * per button. It is only rebuilt when an active scanner asks for it after the
+ * state has changed. The stack has already answered the request that
+ * triggers the rebuild, so a scanner sees the new counts from its next
+ * request onwards. The counts are kept across resets in a PS key, written at
+ * most every BROADCAST_COUNTS_SAVE_INTERVAL seconds (see persist.h).
+ *
+ * With BROADCAST_ENCRYPT the state is sealed with telemetry_Seal() instead:
+ *   <uint16 company id> <uint8 format> <sealed sequence, buttons, joystick>
+ * with the format byte as additional data, and the scan response only
+ * carries the name.
+ */
+
+/** Company identifier used in the manufacturer specific data. */
+#ifndef BROADCAST_COMPANY_ID
+#define BROADCAST_COMPANY_ID 0x02FF
+#endif
+
+/** Name placed in the scan response. */
+#ifndef BROADCAST_NAME
+#define BROADCAST_NAME "BGDemo"
+#endif
+
+/** PS key holding the state change counts. */
+#ifndef BROADCAST_COUNTS_PS_KEY
+#define BROADCAST_COUNTS_PS_KEY 0x4050
+#endif
+
+/** Minimum seconds between writes of the state change counts. */
+#ifndef BROADCAST_COUNTS_SAVE_INTERVAL
+#define BROADCAST_COUNTS_SAVE_INTERVAL 60
+#endif
+
+/** Set to 1 to encrypt the state. See telemetry.h. */
+#ifndef BROADCAST_ENCRYPT
+#define BROADCAST_ENCRYPT 0
+#endif
+
+#define BROADCAST_FORMAT_STATE 0x01
+#define BROADCAST_FORMAT_SEALED_STATE 0x02
+
+/***************************************************************************//**
+ * @brief
+ *   Load the state change counts and set the initial advertising data. Call
+ *   before advertising starts.
+ ******************************************************************************/
+void broadcast_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Update the broadcast button state.
+ *
+ * @param[in] button
+ *   The button number, 0-3.
+ *
+ * @param[in] output
+ *   True if the button pin is an output.
+ ******************************************************************************/
+void broadcast_SetButtonState(uint8 button, bool output);
+
+/***************************************************************************//**
+ * @brief
+ *   Update the broadcast joystick direction.
+ ******************************************************************************/
+void broadcast_SetJoystickDirection(JoystickDirection direction);
+
+/***************************************************************************//**
+ * @brief
+ *   Add a target address to the advertising data, telling a peer that the
+ *   advertisements are meant for it.
+ *
+ * @param[in] address
+ *   The peer address, or NULL to remove the target address.
+ *
+ * @param[in] addressType
+ *   The peer address type, 0 for public or 1 for random.
+ ******************************************************************************/
+void broadcast_SetTargetAddress(const bd_addr *address, uint8 addressType);
+
+/***************************************************************************//**
+ * @brief
+ *   Rebuild the scan response if it is out of date. Call from gecko_evt_le_gap_scan_request().
+ ******************************************************************************/
+void broadcast_ScanRequest(void);
+
+#endif /* BROADCAST_H_ */
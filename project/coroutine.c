@@ -0,0 +1,171 @@
+/*****************************************************************************
+ * @file coroutine.c
+ * @brief Stackless coroutines for long running operations
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "coroutine.h"
+#include "em_device.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "work.h"
+#include "logging.h"
+
+/* Started coroutines */
+static Coroutine *coroutines;
+/* Where the next turn starts looking for a ready coroutine */
+static Coroutine *lastRun;
+
+static void runSlice(void);
+static WorkItem sliceWork = WORK_ITEM(runSlice, "coroutines", COROUTINE_PRIORITY);
+
+/* Fire the timer at the earliest sleep end */
+static void armTimer(void) {
+	uint32 now = appTimerNow();
+	bool sleeping = false;
+	uint32 wait = 0;
+	for (Coroutine *co = coroutines; co; co = co->next) {
+		if (!co->sleeping) {
+			continue;
+		}
+		int32 left = (int32)(co->wakeAt - now);
+		uint32 ticks = left > 0 ? left : 1;
+		if (!sleeping || ticks < wait) {
+			wait = ticks;
+		}
+		sleeping = true;
+	}
+	gecko_cmd_hardware_set_soft_timer(sleeping ? wait : TIMER_STOP, AppTimerIDCoroutine, true);
+}
+
+static Coroutine *nextReady(void) {
+	Coroutine *start = (lastRun && lastRun->next) ? lastRun->next : coroutines;
+	Coroutine *co = start;
+	while (co) {
+		if (co->ready) {
+			return co;
+		}
+		co = co->next ? co->next : coroutines;
+		if (co == start) {
+			break;
+		}
+	}
+	return NULL;
+}
+
+static void removeCoroutine(Coroutine *co) {
+	for (Coroutine **p = &coroutines; *p; p = &(*p)->next) {
+		if (*p == co) {
+			*p = co->next;
+			break;
+		}
+	}
+	co->running = false;
+}
+
+static void runSlice(void) {
+	Coroutine *co = nextReady();
+	if (!co) {
+		return;
+	}
+	co->ready = false;
+	/* Woken before its sleep was over */
+	bool rearm = co->sleeping;
+	co->sleeping = false;
+
+	uint32 start = RTCC_CounterGet();
+	CoroutineStatus status = co->function(co);
+	uint32 slice = RTCC_CounterGet() - start;
+
+	co->slices++;
+	if (slice > co->maxSlice) {
+		co->maxSlice = slice;
+		if (slice > TIMER_MS_2_TIMERTICK(COROUTINE_SLICE_WARNING)) {
+			LogWarn("Coroutine %s ran %lu ms without yielding", co->name, TIMER_TIMERTICK_2_MS(slice));
+		}
+	}
+	rearm |= co->sleeping;
+	if (status == CoroutineYielded) {
+		co->ready = true;
+	}
+	if (status == CoroutineEnded) {
+		removeCoroutine(co);
+		lastRun = NULL;
+	} else {
+		lastRun = co;
+	}
+	if (rearm) {
+		armTimer();
+	}
+	if (nextReady()) {
+		work_Post(&sliceWork);
+	}
+}
+
+bool coroutine_Start(Coroutine *co) {
+	if (co->running) {
+		return false;
+	}
+	co->line = 0;
+	co->running = true;
+	co->sleeping = false;
+	co->next = coroutines;
+	coroutines = co;
+	coroutine_Wake(co);
+	return true;
+}
+
+void coroutine_Wake(Coroutine *co) {
+	if (co->running) {
+		co->ready = true;
+		work_Post(&sliceWork);
+	}
+}
+
+bool coroutine_Running(const Coroutine *co) {
+	return co->running;
+}
+
+void coroutine_SleepFor(Coroutine *co, uint32 ms) {
+	co->sleeping = true;
+	co->wakeAt = appTimerNow() + TIMER_MS_2_TIMERTICK(ms);
+}
+
+void coroutine_Timer(void) {
+	uint32 now = appTimerNow();
+	for (Coroutine *co = coroutines; co; co = co->next) {
+		if (co->sleeping && (int32)(now - co->wakeAt) >= 0) {
+			co->sleeping = false;
+			coroutine_Wake(co);
+		}
+	}
+	armTimer();
+}
@@ -0,0 +1,150 @@
+/*****************************************************************************
+ * @file coroutine.h
+ * @brief Stackless coroutines for long running operations
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef COROUTINE_H_
+#define COROUTINE_H_
+
+#include "bg_types.h"
+
+/* Long operations are written as stackless coroutines (protothreads), which
+ * return to the event loop between bounded slices of work and carry on from
+ * where they left off. A coroutine needs no stack of its own: it is a
+ * function taking its Coroutine, which holds where to resume.
+ *
+ *   static uint8 row;
+ *   static CoroutineStatus draw(Coroutine *co) {
+ *       CO_BEGIN(co);
+ *       for (row = 0; row < 128; row++) {
+ *           drawRow(row);
+ *           CO_YIELD(co);
+ *       }
+ *       CO_END(co);
+ *   }
+ *   static Coroutine drawing = COROUTINE(draw, "draw");
+ *   ...
+ *   coroutine_Start(&drawing);
+ *
+ * Local variables are lost at every CO_ macro that can return, so anything
+ * kept across them must be static or in a struct of the caller's. Each CO_
+ * macro must be on its own line, and a coroutine must not use switch
+ * statements around them.
+ *
+ * Ready coroutines are run one slice at a time, in turn, from a work item at
+ * COROUTINE_PRIORITY (see work.h), so events are handled between slices.
+ * A coroutine resumes
+ *   - after CO_YIELD, on the next turn
+ *   - after CO_SLEEP, once the time has passed (AppTimerIDCoroutine)
+ *   - at CO_WAIT_UNTIL, each time coroutine_Wake() is called, e.g. from an
+ *     event handler or an interrupt, until the condition is true
+ *
+ * The longest slice of each coroutine is kept, and a new longest slice over
+ * COROUTINE_SLICE_WARNING ms is logged.
+ */
+
+/** Work queue priority slices run at. */
+#ifndef COROUTINE_PRIORITY
+#define COROUTINE_PRIORITY WorkPriorityLow
+#endif
+
+/** Slice in ms beyond which a new longest slice is logged. */
+#ifndef COROUTINE_SLICE_WARNING
+#define COROUTINE_SLICE_WARNING 10
+#endif
+
+typedef enum {
+	CoroutineYielded,
+	CoroutineWaiting,
+	CoroutineEnded,
+} CoroutineStatus;
+
+typedef struct Coroutine Coroutine;
+typedef CoroutineStatus (*CoroutineFunction)(Coroutine *co);
+
+struct Coroutine {
+	CoroutineFunction function;
+	/** Name used in the log */
+	const char *name;
+	/* Owned by coroutine.c and the CO_ macros */
+	uint16 line;
+	bool running;
+	volatile bool ready;
+	bool sleeping;
+	uint32 wakeAt;
+	struct Coroutine *next;
+	/** Longest slice, in RTCC ticks (TIMER_CLK_FREQ per second) */
+	uint32 maxSlice;
+	uint32 slices;
+};
+
+/** Initialiser for a coroutine. */
+#define COROUTINE(function, name) { (function), (name) }
+
+#define CO_BEGIN(co) switch ((co)->line) { case 0:
+#define CO_END(co) } (co)->line = 0; return CoroutineEnded
+#define CO_EXIT(co) do { (co)->line = 0; return CoroutineEnded; } while (0)
+#define CO_YIELD(co) do { (co)->line = __LINE__; return CoroutineYielded; case __LINE__:; } while (0)
+#define CO_WAIT_UNTIL(co, condition) do { (co)->line = __LINE__; case __LINE__: if (!(condition)) { return CoroutineWaiting; } } while (0)
+#define CO_SLEEP(co, ms) do { coroutine_SleepFor((co), (ms)); (co)->line = __LINE__; return CoroutineWaiting; case __LINE__:; } while (0)
+
+/***************************************************************************//**
+ * @brief
+ *   Start a coroutine from the beginning.
+ *
+ * @return
+ *   False if it is already running.
+ ******************************************************************************/
+bool coroutine_Start(Coroutine *co);
+
+/***************************************************************************//**
+ * @brief
+ *   Run a waiting or sleeping coroutine again. Safe from interrupts.
+ ******************************************************************************/
+void coroutine_Wake(Coroutine *co);
+
+/***************************************************************************//**
+ * @brief
+ *   Whether a coroutine has been started and not ended.
+ ******************************************************************************/
+bool coroutine_Running(const Coroutine *co);
+
+/** Used by CO_SLEEP. */
+void coroutine_SleepFor(Coroutine *co, uint32 ms);
+
+/***************************************************************************//**
+ * @brief
+ *   Wake the coroutines whose sleep is over. Call when the
+ *   AppTimerIDCoroutine timer fires.
+ ******************************************************************************/
+void coroutine_Timer(void);
+
+#endif /* COROUTINE_H_ */
@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * @file crc.c
+ * @brief CRC-32 on the GPCRC peripheral
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "crc.h"
+#include "em_device.h"
+#include "em_gpcrc.h"
+#include "logging.h"
+
+#define CRC32_POLYNOMIAL 0x04C11DB7
+
+/* Reflected polynomial 0xEDB88320, a nibble at a time */
+static const uint32 nibbleTable[16] = {
+	0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+	0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+static bool hardware;
+
+uint32 crc_Crc32Software(uint32 crc, const void *data, uint32 len) {
+	const uint8 *p = data;
+	crc = ~crc;
+	while (len--) {
+		crc ^= *p++;
+		crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+		crc = (crc >> 4) ^ nibbleTable[crc & 0x0F];
+	}
+	return ~crc;
+}
+
+static uint32 hardwareCrc32(uint32 crc, const uint8 *data, uint32 len) {
+	GPCRC_InitValueSet(GPCRC, ~crc);
+	GPCRC_Start(GPCRC);
+	while (len > 0 && ((uintptr_t) data & 3) != 0) {
+		GPCRC_InputU8(GPCRC, *data++);
+		len--;
+	}
+	/* A word per write, each taking a cycle, so DMA would be no faster */
+	uint32 words = len / 4;
+	for (uint32 i = 0; i < words; i++) {
+		GPCRC_InputU32(GPCRC, ((const uint32 *) data)[i]);
+	}
+	data += words * 4;
+	len -= words * 4;
+	while (len-- > 0) {
+		GPCRC_InputU8(GPCRC, *data++);
+	}
+	return ~GPCRC_DataGet(GPCRC);
+}
+
+/* Check a continued CRC, as well as a whole one, against the known check value */
+static bool selfTest(void) {
+	static const uint8 check[] = "123456789";
+	uint32 crc = hardwareCrc32(0, check, 4);
+	crc = hardwareCrc32(crc, &check[4], 5);
+	return crc == 0xCBF43926 && hardwareCrc32(0, check, 9) == 0xCBF43926;
+}
+
+void crc_Init(void) {
+	/* The GPCRC shifts least significant bit first, which is the reflected
+	 * CRC-32 with the input and result in their natural bit order */
+	GPCRC_Init_TypeDef init = GPCRC_INIT_DEFAULT;
+	init.crcPoly = CRC32_POLYNOMIAL;
+	init.reverseBits = false;
+	GPCRC_Init(GPCRC, &init);
+	hardware = selfTest();
+	if (!hardware) {
+		LogWarn("GPCRC self test failed, using software CRC");
+	}
+}
+
+uint32 crc_Crc32(uint32 crc, const void *data, uint32 len) {
+	if (!hardware) {
+		return crc_Crc32Software(crc, data, len);
+	}
+	return hardwareCrc32(crc, data, len);
+}
@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * @file crc.h
+ * @brief CRC-32 on the GPCRC peripheral
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef CRC_H_
+#define CRC_H_
+
+#include "bg_types.h"
+
+/* CRC-32 as used by zlib and Ethernet (reflected, polynomial 0x04C11DB7,
+ * initial value and final XOR 0xFFFFFFFF), computed by the GPCRC peripheral
+ * a word at a time.
+ *
+ * crc_Init() checks the peripheral against the known check value and falls
+ * back to software if they disagree. tools/crc32.py is the host
+ * reference.
+ */
+
+/***************************************************************************//**
+ * @brief
+ *   Configure the GPCRC. Call once after the clocks are enabled.
+ ******************************************************************************/
+void crc_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Calculate or continue a CRC-32.
+ *
+ * @param[in] crc
+ *   0 to start, or the result for the data so far to continue.
+ *
+ * @param[in] data
+ *   The data.
+ *
+ * @param[in] len
+ *   The number of bytes.
+ *
+ * @return
+ *   The CRC-32 of all the data so far.
+ ******************************************************************************/
+uint32 crc_Crc32(uint32 crc, const void *data, uint32 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Software implementation of crc_Crc32(), used when the GPCRC is unavailable.
+ ******************************************************************************/
+uint32 crc_Crc32Software(uint32 crc, const void *data, uint32 len);
+
+#endif /* CRC_H_ */
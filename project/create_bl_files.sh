@@ -21,12 +21,14 @@ fi
 
 # use PATH_OUT env var to override the full path for the .out file
 
+# use DELTA_REFERENCE env var to point at the output_gbl folder of the build
+# installed on the devices, to also create delta images against it
+
 # default file extension of GCC and IAR
 FILE_EXTENSION_GCC="*.axf"
 FILE_EXTENSION_IAR="*.out"
 
-# output path of the OTA and UART DFU ebl and gbl files (relative to project root)
-PATH_EBL="output_ebl"
+# output path of the OTA and UART DFU gbl files (relative to project root)
 PATH_GBL="output_gbl"
 
 # names of the OTA and UART DFU output files
@@ -65,59 +67,83 @@ if [[ ! -f "${COMMANDER}" ]]; then
 fi
 
 echo "**********************************************************************"
-echo "Converting .out to .ebl files"
+echo "Converting .out to .gbl files"
 echo "**********************************************************************"
 echo
 echo ".out file used:"
 echo "${PATH_OUT}"
 echo
-echo "output folders:"
-echo "${0%/*}${PATH_EBL}"
+echo "output folder:"
 echo "${0%/*}${PATH_GBL}"
 
-mkdir -p ${PATH_EBL}
 mkdir -p ${PATH_GBL}
 
-# create the EBL & GBL files
+# create the GBL files for the Gecko bootloader
 echo
 echo "**********************************************************************"
-echo "Creating ${OTA_STACK_NAME}.ebl and ${OTA_STACK_NAME}.gbl for OTA"
+echo "Creating ${OTA_STACK_NAME}.gbl for OTA"
 echo "**********************************************************************"
 echo
-"${OBJCOPY}" -O srec -j .text_stack* "${PATH_OUT}" "${PATH_EBL}/${OTA_STACK_NAME}.srec"
+"${OBJCOPY}" -O srec -j .text_stack* "${PATH_OUT}" "${PATH_GBL}/${OTA_STACK_NAME}.srec"
 if [ $? -ne 0 ]; then
   read -rsp $'Press enter to continue...\n'
   exit
 fi
-"${COMMANDER}" ebl create "${PATH_EBL}/${OTA_STACK_NAME}.ebl" --app "${PATH_EBL}/${OTA_STACK_NAME}.srec" -d EFR32F256
-"${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}.gbl" --app "${PATH_EBL}/${OTA_STACK_NAME}.srec"
+"${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}.gbl" --app "${PATH_GBL}/${OTA_STACK_NAME}.srec"
 
 echo 
 echo "**********************************************************************"
-echo "Creating ${OTA_APP_NAME}.ebl and ${OTA_APP_NAME}.gbl for OTA"
+echo "Creating ${OTA_APP_NAME}.gbl for OTA"
 echo "**********************************************************************"
 echo
-"${OBJCOPY}" -O srec -j .text_app* "${PATH_OUT}" "${PATH_EBL}/${OTA_APP_NAME}.srec"
+"${OBJCOPY}" -O srec -j .text_app* "${PATH_OUT}" "${PATH_GBL}/${OTA_APP_NAME}.srec"
 if [ $? -ne 0 ]; then
   read -rsp $'Press enter to continue...\n'
   exit
 fi
-"${COMMANDER}" ebl create "${PATH_EBL}/${OTA_APP_NAME}.ebl" --app "${PATH_EBL}/${OTA_APP_NAME}.srec" -d EFR32F256
-"${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}.gbl" --app "${PATH_EBL}/${OTA_APP_NAME}.srec"
+"${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}.gbl" --app "${PATH_GBL}/${OTA_APP_NAME}.srec"
 
-# create the full EBL & GBL files for UART DFU
+# create the full GBL file for UART DFU
 echo
 echo "**********************************************************************"
-echo "Creating ${UARTDFU_FULL_NAME}.ebl and ${UARTDFU_FULL_NAME}.gbl for UART DFU"
+echo "Creating ${UARTDFU_FULL_NAME}.gbl for UART DFU"
 echo "**********************************************************************"
 echo
-"${OBJCOPY}" -O srec -R .text_bootloader* "${PATH_OUT}" "${PATH_EBL}/${UARTDFU_FULL_NAME}.srec"
+"${OBJCOPY}" -O srec -R .text_bootloader* "${PATH_OUT}" "${PATH_GBL}/${UARTDFU_FULL_NAME}.srec"
 if [ $? -ne 0 ]; then
   read -rsp $'Press enter to continue...\n'
   exit
 fi
-"${COMMANDER}" ebl create "${PATH_EBL}/${UARTDFU_FULL_NAME}.ebl" --app "${PATH_EBL}/${UARTDFU_FULL_NAME}.srec" -d EFR32F256
-"${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}.gbl" --app "${PATH_EBL}/${UARTDFU_FULL_NAME}.srec"
+"${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}.gbl" --app "${PATH_GBL}/${UARTDFU_FULL_NAME}.srec"
+
+# list the hot code and tables copied to RAM, see ram_code.h
+echo
+echo "**********************************************************************"
+echo "Code and tables placed in RAM"
+echo "**********************************************************************"
+echo
+python3 tools/ram_report.py --nm "${OBJCOPY%objcopy}nm" "${PATH_OUT}"
+
+# create delta GBL files against the reference build if given
+if [[ -n ${DELTA_REFERENCE} ]]; then
+  echo
+  echo "**********************************************************************"
+  echo "Creating delta .gbl files against ${DELTA_REFERENCE}"
+  echo "**********************************************************************"
+  echo
+  for NAME in ${OTA_STACK_NAME} ${OTA_APP_NAME} ${UARTDFU_FULL_NAME}; do
+    if [[ -f "${DELTA_REFERENCE}/${NAME}.gbl" ]]; then
+      python3 tools/delta.py create "${DELTA_REFERENCE}/${NAME}.gbl" "${PATH_GBL}/${NAME}.gbl" "${PATH_GBL}/${NAME}-delta.bin"
+      # round trip the delta to check it rebuilds the new image
+      python3 tools/delta.py verify "${DELTA_REFERENCE}/${NAME}.gbl" "${PATH_GBL}/${NAME}.gbl" "${PATH_GBL}/${NAME}-delta.bin"
+      if [ $? -ne 0 ]; then
+        rm "${PATH_GBL}/${NAME}-delta.bin"
+        read -rsp $'Press enter to continue...\n'
+        exit
+      fi
+    fi
+  done
+fi
 
 # create encrypted GBL file for secure boot if encrypt-key file exist
 if [[ -f $GBL_ENCRYPT_KEY_FILE ]]; then
@@ -126,11 +152,11 @@ if [[ -f $GBL_ENCRYPT_KEY_FILE ]]; then
   echo "Creating encrypted .gbl files"
   echo "**********************************************************************"
   echo
-  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-encrypted.gbl" --app "${PATH_EBL}/${OTA_STACK_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
+  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-encrypted.gbl" --app "${PATH_GBL}/${OTA_STACK_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
   echo
-  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-encrypted.gbl" --app "${PATH_EBL}/${OTA_APP_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
+  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-encrypted.gbl" --app "${PATH_GBL}/${OTA_APP_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
   echo
-  "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-encrypted.gbl" --app "${PATH_EBL}/${UARTDFU_FULL_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
+  "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-encrypted.gbl" --app "${PATH_GBL}/${UARTDFU_FULL_NAME}.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE}
 fi
 
 # create signed GBL file for secure boot if sign-key file exists
@@ -140,14 +166,14 @@ if [[ -f $GBL_SIGING_KEY_FILE ]]; then
   echo "Creating signed .gbl files"
   echo "**********************************************************************"
   echo
-  "${COMMANDER}" convert "${PATH_EBL}/${OTA_STACK_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_EBL}/${OTA_STACK_NAME}-signed.srec"
-  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-signed.gbl" --app "${PATH_EBL}/${OTA_STACK_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
+  "${COMMANDER}" convert "${PATH_GBL}/${OTA_STACK_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_GBL}/${OTA_STACK_NAME}-signed.srec"
+  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-signed.gbl" --app "${PATH_GBL}/${OTA_STACK_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
   echo
-  "${COMMANDER}" convert "${PATH_EBL}/${OTA_APP_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_EBL}/${OTA_APP_NAME}-signed.srec"
-  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-signed.gbl" --app "${PATH_EBL}/${OTA_APP_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
+  "${COMMANDER}" convert "${PATH_GBL}/${OTA_APP_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_GBL}/${OTA_APP_NAME}-signed.srec"
+  "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-signed.gbl" --app "${PATH_GBL}/${OTA_APP_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
   echo
-  "${COMMANDER}" convert "${PATH_EBL}/${UARTDFU_FULL_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_EBL}/${UARTDFU_FULL_NAME}-signed.srec"
-  "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed.gbl" --app "${PATH_EBL}/${UARTDFU_FULL_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
+  "${COMMANDER}" convert "${PATH_GBL}/${UARTDFU_FULL_NAME}.srec" --secureboot --keyfile ${GBL_SIGING_KEY_FILE} -o "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed.srec"
+  "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed.gbl" --app "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed.srec" --sign ${GBL_SIGING_KEY_FILE}
   
   # create signed and encrypted GBL file for if both sign-key and encrypt-key file exist
   if [[ -f $GBL_ENCRYPT_KEY_FILE ]]; then
@@ -156,15 +182,15 @@ if [[ -f $GBL_SIGING_KEY_FILE ]]; then
     echo "Creating signed and encrypted .gbl files"
     echo "**********************************************************************"
     echo
-    "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-signed-encrypted.gbl" --app "${PATH_EBL}/${OTA_STACK_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
+    "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_STACK_NAME}-signed-encrypted.gbl" --app "${PATH_GBL}/${OTA_STACK_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
     echo
-    "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-signed-encrypted.gbl" --app "${PATH_EBL}/${OTA_APP_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
+    "${COMMANDER}" gbl create "${PATH_GBL}/${OTA_APP_NAME}-signed-encrypted.gbl" --app "${PATH_GBL}/${OTA_APP_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
     echo
-    "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed-encrypted.gbl" --app "${PATH_EBL}/${UARTDFU_FULL_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
+    "${COMMANDER}" gbl create "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed-encrypted.gbl" --app "${PATH_GBL}/${UARTDFU_FULL_NAME}-signed.srec" --encrypt ${GBL_ENCRYPT_KEY_FILE} --sign ${GBL_SIGING_KEY_FILE}
   fi
 fi
 
 # clean up output dir
-rm "${PATH_EBL}"/*.srec
+rm "${PATH_GBL}"/*.srec
 
 read -rsp $'Press enter to continue...\n'
\ No newline at end of file
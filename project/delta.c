@@ -0,0 +1,204 @@
+/*****************************************************************************
+ * @file delta.c
+ * @brief Streaming decoder for delta upgrade images
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "delta.h"
+#include "util.h"
+#include <string.h>
+
+/* Bytes copied per read back */
+#define COPY_CHUNK 64
+
+typedef enum {
+	PhaseOp = 0,
+	PhaseLength,
+	PhaseArgument,
+	PhaseData,
+} Phase;
+
+void delta_Init(DeltaDecoder *d) {
+	memset(d, 0, sizeof(*d));
+}
+
+bool delta_HeaderDone(const DeltaDecoder *d) {
+	return d->headerLength == DELTA_HEADER_SIZE;
+}
+
+static bool parseHeader(DeltaDecoder *d) {
+	if (memcmp(d->header, DELTA_MAGIC, 4) != 0) {
+		return false;
+	}
+	d->sourceSize = getUint32(&d->header[4]);
+	d->sourceCrc = getUint32(&d->header[8]);
+	d->targetSize = getUint32(&d->header[12]);
+	d->targetCrc = getUint32(&d->header[16]);
+	return true;
+}
+
+/* Accumulate a varint byte, returns true when the value is complete */
+static bool varint(DeltaDecoder *d, uint8 byte) {
+	if (d->shift > 28) {
+		d->status = DeltaStatusBadOp;
+		return false;
+	}
+	d->value |= (uint32) (byte & 0x7F) << d->shift;
+	d->shift += 7;
+	return (byte & 0x80) == 0;
+}
+
+/* Validate a copy once its argument is known and set where it reads from */
+static void startCopy(DeltaDecoder *d) {
+	if (d->op == DeltaOpCopySource) {
+		/* zigzag decode */
+		int32 delta = (int32) (d->value >> 1) ^ -(int32) (d->value & 1);
+		uint32 from = d->sourceOffset + delta;
+		if (from > d->sourceSize || d->length > d->sourceSize - from) {
+			d->status = DeltaStatusOutOfRange;
+			return;
+		}
+		d->copyFrom = from;
+		d->sourceOffset = from + d->length;
+	} else {
+		if (d->value == 0 || d->value > d->written) {
+			d->status = DeltaStatusOutOfRange;
+			return;
+		}
+		d->copyFrom = d->written - d->value;
+	}
+	d->phase = PhaseData;
+}
+
+/* Run the copy in progress while there is output space */
+static void copy(DeltaDecoder *d, const DeltaIO *io) {
+	uint8 buffer[COPY_CHUNK];
+	while (d->length > 0) {
+		uint16 len = MIN(io->space(), MIN(d->length, COPY_CHUNK));
+		if (d->op == DeltaOpCopyTarget) {
+			/* An overlapping copy can only read what has been written */
+			len = MIN(len, d->written - d->copyFrom);
+		}
+		if (len == 0) {
+			return;
+		}
+		if (d->op == DeltaOpCopySource) {
+			io->readSource(d->copyFrom, buffer, len);
+		} else {
+			io->readTarget(d->copyFrom, buffer, len);
+		}
+		io->write(buffer, len);
+		d->copyFrom += len;
+		d->written += len;
+		d->length -= len;
+	}
+	d->phase = PhaseOp;
+}
+
+uint32 delta_Decode(DeltaDecoder *d, const DeltaIO *io, const uint8 *data, uint32 len) {
+	uint32 consumed = 0;
+	while (d->status == DeltaStatusOK) {
+		if (!delta_HeaderDone(d)) {
+			if (consumed == len) {
+				break;
+			}
+			d->header[d->headerLength++] = data[consumed++];
+			if (delta_HeaderDone(d) && !parseHeader(d)) {
+				d->status = DeltaStatusBadHeader;
+			}
+			continue;
+		}
+		if (d->phase == PhaseData) {
+			if (d->op == DeltaOpLiteral) {
+				uint32 n = MIN(MIN(d->length, len - consumed), io->space());
+				if (n == 0) {
+					break;
+				}
+				io->write(&data[consumed], n);
+				consumed += n;
+				d->written += n;
+				d->length -= n;
+				if (d->length == 0) {
+					d->phase = PhaseOp;
+				}
+			} else {
+				copy(d, io);
+				if (d->phase == PhaseData) {
+					break;
+				}
+			}
+			continue;
+		}
+		if (d->phase == PhaseOp && d->written == d->targetSize) {
+			d->status = DeltaStatusDone;
+			break;
+		}
+		if (consumed == len) {
+			break;
+		}
+		uint8 byte = data[consumed++];
+		switch (d->phase) {
+		case PhaseOp:
+			if (byte > DeltaOpCopyTarget) {
+				d->status = DeltaStatusBadOp;
+				break;
+			}
+			d->op = byte;
+			d->phase = PhaseLength;
+			d->value = 0;
+			d->shift = 0;
+			break;
+		case PhaseLength:
+			if (varint(d, byte)) {
+				d->length = d->value;
+				if (d->length == 0) {
+					d->status = DeltaStatusBadOp;
+					break;
+				}
+				if (d->length > d->targetSize - d->written) {
+					d->status = DeltaStatusOutOfRange;
+					break;
+				}
+				d->value = 0;
+				d->shift = 0;
+				d->phase = d->op == DeltaOpLiteral ? PhaseData : PhaseArgument;
+			}
+			break;
+		case PhaseArgument:
+			if (varint(d, byte)) {
+				startCopy(d);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	return consumed;
+}
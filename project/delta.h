@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * @file delta.h
+ * @brief Streaming decoder for delta upgrade images
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef DELTA_H_
+#define DELTA_H_
+
+#include "bg_types.h"
+
+/* A delta image rebuilds a new upgrade image from the one already in the
+ * SPI flash. It is produced by tools/delta.py from the reference build and
+ * the new build. All values are little endian, lengths and offsets are LEB128
+ * varints.
+ *
+ * Header:
+ *   "BGDP" <uint32 source size> <uint32 source crc32> <uint32 target size> <uint32 target crc32>
+ * Then operations until target size bytes have been produced:
+ *   0x00 <len> <len bytes>  - literal bytes
+ *   0x01 <len> <delta>      - copy from the source, at the end of the previous
+ *                             source copy plus delta (zigzag encoded)
+ *   0x02 <len> <distance>   - copy from the target written distance bytes back,
+ *                             which may overlap the bytes being written
+ *
+ * The decoder only holds the operation being decoded, so it needs a fixed
+ * amount of RAM whatever the image size. Copies read the source and earlier
+ * target bytes back through callbacks.
+ */
+
+#define DELTA_MAGIC "BGDP"
+#define DELTA_HEADER_SIZE 20
+
+typedef enum {
+	DeltaOpLiteral = 0x00,
+	DeltaOpCopySource = 0x01,
+	DeltaOpCopyTarget = 0x02,
+} DeltaOp;
+
+typedef enum {
+	DeltaStatusOK = 0,
+	DeltaStatusDone,
+	DeltaStatusBadHeader,
+	DeltaStatusBadOp,
+	DeltaStatusOutOfRange,
+} DeltaStatus;
+
+typedef struct {
+	/** Bytes that can be written now */
+	uint16 (*space)(void);
+	/** Write up to space() bytes */
+	void (*write)(const uint8 *data, uint16 len);
+	/** Read bytes of the source image */
+	void (*readSource)(uint32 offset, uint8 *data, uint16 len);
+	/** Read bytes of the target image already written */
+	void (*readTarget)(uint32 offset, uint8 *data, uint16 len);
+} DeltaIO;
+
+typedef struct {
+	DeltaStatus status;
+	uint32 sourceSize;
+	uint32 sourceCrc;
+	uint32 targetSize;
+	uint32 targetCrc;
+	/* Target bytes written */
+	uint32 written;
+	/* Position in the header or operation being decoded */
+	uint8 header[DELTA_HEADER_SIZE];
+	uint8 headerLength;
+	uint8 phase;
+	uint8 op;
+	uint8 shift;
+	uint32 value;
+	uint32 length;
+	uint32 sourceOffset;
+	uint32 copyFrom;
+} DeltaDecoder;
+
+/***************************************************************************//**
+ * @brief
+ *   Reset the decoder for a new delta image.
+ ******************************************************************************/
+void delta_Init(DeltaDecoder *decoder);
+
+/***************************************************************************//**
+ * @brief
+ *   Decode as much as the input and output space allow.
+ *
+ * @details
+ *   Call again with more input, or with no input once there is more output
+ *   space, until the status is no longer DeltaStatusOK.
+ *
+ * @param[in] decoder
+ *   The decoder.
+ *
+ * @param[in] io
+ *   The output and read back callbacks.
+ *
+ * @param[in] data
+ *   The next bytes of the delta image.
+ *
+ * @param[in] len
+ *   The number of bytes.
+ *
+ * @return
+ *   The number of input bytes consumed. The rest must be passed again.
+ ******************************************************************************/
+uint32 delta_Decode(DeltaDecoder *decoder, const DeltaIO *io, const uint8 *data, uint32 len);
+
+/***************************************************************************//**
+ * @brief
+ *   True once the header has been decoded and the size and CRC fields are valid.
+ ******************************************************************************/
+bool delta_HeaderDone(const DeltaDecoder *decoder);
+
+#endif /* DELTA_H_ */
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * @file display_polarity.c
+ * @brief Hardware EXTCOMIN toggling for the memory LCD
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "display_polarity.h"
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_gpio.h"
+#include "em_letimer.h"
+#include "displayconfigall.h"
+#include "logging.h"
+
+/* The LETIMER counter is 16 bits */
+#define MAX_TOP 0xFFFF
+
+bool displayPolarity_Start(unsigned int frequency) {
+	CMU_ClockEnable(cmuClock_LETIMER0, true);
+	uint32 clock = CMU_ClockFreqGet(cmuClock_LETIMER0);
+	if (frequency == 0 || clock / frequency == 0 || clock / frequency - 1 > MAX_TOP) {
+		LogWarn("EXTCOMIN frequency %u not possible on LETIMER0", frequency);
+		CMU_ClockEnable(cmuClock_LETIMER0, false);
+		return false;
+	}
+
+	LETIMER_Init_TypeDef init = LETIMER_INIT_DEFAULT;
+	init.enable = false;
+	/* Count down from COMP0 and toggle OUT0 on every underflow */
+	init.comp0Top = true;
+	init.ufoa0 = letimerUFOAToggle;
+	init.repMode = letimerRepeatFree;
+	LETIMER_Init(LETIMER0, &init);
+	LETIMER_CompareSet(LETIMER0, 0, clock / frequency - 1);
+	/* Output actions only happen while REP0 is non-zero, even in free mode */
+	LETIMER_RepeatSet(LETIMER0, 0, 1);
+
+	GPIO_PinModeSet(LCD_PORT_EXTCOMIN, LCD_PIN_EXTCOMIN, gpioModePushPull, 0);
+	LETIMER0->ROUTELOC0 = (LETIMER0->ROUTELOC0 & ~_LETIMER_ROUTELOC0_OUT0LOC_MASK) | (DISPLAY_POLARITY_LOCATION << _LETIMER_ROUTELOC0_OUT0LOC_SHIFT);
+	LETIMER0->ROUTEPEN |= LETIMER_ROUTEPEN_OUT0PEN;
+	LETIMER_Enable(LETIMER0, true);
+	return true;
+}
+
+void displayPolarity_Stop(void) {
+	LETIMER_Enable(LETIMER0, false);
+	LETIMER0->ROUTEPEN &= ~LETIMER_ROUTEPEN_OUT0PEN;
+	LETIMER_Reset(LETIMER0);
+	CMU_ClockEnable(cmuClock_LETIMER0, false);
+}
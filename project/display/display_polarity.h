@@ -0,0 +1,78 @@
+/*****************************************************************************
+ * @file display_polarity.h
+ * @brief Hardware EXTCOMIN toggling for the memory LCD
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef DISPLAY_POLARITY_H_
+#define DISPLAY_POLARITY_H_
+
+#include "bg_types.h"
+
+/* The Sharp memory LCD needs its EXTCOMIN pin toggled periodically to stop a
+ * DC bias building up. Rather than waking from EM2 to toggle it from a soft
+ * timer, LETIMER0 can drive the pin directly in toggle mode, which carries on
+ * in EM2 with no software involvement once started.
+ *
+ * LETIMER0 OUT0 must be able to reach the EXTCOMIN pin: set
+ * DISPLAY_POLARITY_LOCATION to the OUT0 location of LCD_PORT_EXTCOMIN /
+ * LCD_PIN_EXTCOMIN from the device datasheet. The default, 21, is PD13.
+ */
+
+/** Set to 0 to always toggle EXTCOMIN from the soft timer. */
+#ifndef DISPLAY_POLARITY_LETIMER
+#define DISPLAY_POLARITY_LETIMER 1
+#endif
+
+/** LETIMER0 OUT0 location of the EXTCOMIN pin. */
+#ifndef DISPLAY_POLARITY_LOCATION
+#define DISPLAY_POLARITY_LOCATION 21
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Start LETIMER0 toggling EXTCOMIN.
+ *
+ * @param[in] frequency
+ *   Toggles per second, as requested by the display driver.
+ *
+ * @return
+ *   True if LETIMER0 is toggling the pin, false if the frequency can't be
+ *   generated, in which case the caller must toggle it in software.
+ ******************************************************************************/
+bool displayPolarity_Start(unsigned int frequency);
+
+/***************************************************************************//**
+ * @brief
+ *   Stop LETIMER0 and release the pin.
+ ******************************************************************************/
+void displayPolarity_Stop(void);
+
+#endif /* DISPLAY_POLARITY_H_ */
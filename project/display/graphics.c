@@ -53,8 +53,11 @@ static int32_t joystickCenterX;
 static int32_t joystickCenterY;
 static GLIB_Rectangle_t buttonBounds[4];
 static int32_t buttonCenterX[4];
+static GLIB_Rectangle_t passkeyBounds;
 
 static const uint32_t circleRadius = 10;
+static bool updatesDeferred;
+static bool updatePending;
 
 /***************************************************************************************************
  Static Function Declarations
@@ -63,6 +66,22 @@ static const uint32_t circleRadius = 10;
 /***************************************************************************************************
  Function Definitions
  **************************************************************************************************/
+static void updateDisplay(void) {
+	if (updatesDeferred) {
+		updatePending = true;
+	} else {
+		DMD_updateDisplay();
+	}
+}
+
+void graphSetUpdatesDeferred(bool deferred) {
+	updatesDeferred = deferred;
+	if (!deferred && updatePending) {
+		updatePending = false;
+		DMD_updateDisplay();
+	}
+}
+
 void graphInit(void) {
 	EMSTATUS status;
 
@@ -99,6 +118,11 @@ void graphInit(void) {
 	joystickBounds.yMax = joystickBounds.yMax / 2;
 	joystickCenterY = (joystickBounds.yMax - joystickBounds.yMin)/2 - 5;
 
+	/* Between the joystick and the button labels */
+	passkeyBounds = glibContext.clippingRegion;
+	passkeyBounds.yMin = joystickBounds.yMax + 1;
+	passkeyBounds.yMax = passkeyBounds.yMin + glibContext.font.fontHeight;
+
 	{
 		const int32_t y = 90;
 		const int32_t height = 2 * circleRadius + 5 + glibContext.font.fontHeight;
@@ -122,7 +146,7 @@ void graphInit(void) {
 		}
 	}
 
-	DMD_updateDisplay();
+	updateDisplay();
 }
 
 /***************************************************************************************************
@@ -272,7 +296,7 @@ void graphSetJoystickDirection(JoystickDirection direction) {
 		}
 	}
 
-	DMD_updateDisplay();
+	updateDisplay();
 }
 
 void graphSetButtonState(uint8_t buttonNum, bool on) {
@@ -294,5 +318,28 @@ void graphSetButtonState(uint8_t buttonNum, bool on) {
 	uint8_t posY = buttonBounds[buttonNum].yMax - glibContext.font.fontHeight;
 	GLIB_drawString(&glibContext, on ? onText : offText, len, posX, posY, 0);
 
+	updateDisplay();
+}
+
+void graphSetPasskey(uint32_t passkey, bool shown) {
+	clearRect(passkeyBounds);
+	if (shown) {
+		char text[16];
+		snprintf(text, sizeof(text), "Passkey %06lu", (unsigned long) passkey);
+		graphPrintCenter(&glibContext, passkeyBounds.yMin, text);
+	}
+	updateDisplay();
+}
+
+void graphSleep(void) {
+	/* Clear the panel before powering it down, as the panel asks */
+	GLIB_clear(&glibContext);
+	updatesDeferred = false;
+	updatePending = false;
 	DMD_updateDisplay();
+
+	DISPLAY_Device_t device;
+	if (DISPLAY_DeviceGet(0, &device) == DISPLAY_EMSTATUS_OK && device.pDisplayPowerOn) {
+		device.pDisplayPowerOn(&device, false);
+	}
 }
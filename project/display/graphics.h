@@ -32,6 +32,25 @@ void graphSetJoystickDirection(JoystickDirection direction);
 
 void graphSetButtonState(uint8_t buttonNum, bool on);
 
+/***********************************************************************************************//**
+ *  \brief  Show or clear the passkey to enter on the peer while pairing
+ *  \param[in]  passkey  Passkey to show
+ *  \param[in]  shown  False to clear it
+ **************************************************************************************************/
+void graphSetPasskey(uint32_t passkey, bool shown);
+
+/***********************************************************************************************//**
+ *  \brief  Defer display updates, so several changes are sent to the display in one frame
+ *  \param[in]  deferred  True to start deferring, false to send any changes and stop deferring
+ **************************************************************************************************/
+void graphSetUpdatesDeferred(bool deferred);
+
+/***********************************************************************************************//**
+ *  \brief  Blank the display and power it down, so it can be left without EXTCOMIN toggling.
+ *           graphInit() powers it up again and draws a full frame.
+ **************************************************************************************************/
+void graphSleep(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,360 @@
+/*****************************************************************************
+ * @file event_log.c
+ * @brief Circular event log in the SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "event_log.h"
+#include "util.h"
+#include "board_features.h"
+#include "native_gecko.h"
+
+#ifdef FEATURE_SPI_FLASH
+
+#include <string.h>
+#include "gatt_db.h"
+#include "app_timer.h"
+#include "throughput.h"
+#include "crc.h"
+#include "logging.h"
+
+#define PAGES (EVENT_LOG_SIZE / SPI_FLASH_PAGE_SIZE)
+#define PAGES_PER_SECTOR (SPI_FLASH_SECTOR_SIZE / SPI_FLASH_PAGE_SIZE)
+#define PAGE_ADDRESS(sequence) (EVENT_LOG_ADDRESS + ((sequence) % PAGES) * SPI_FLASH_PAGE_SIZE)
+#define PAGE_HEADER_LENGTH 6
+#define PAGE_CRC_OFFSET (SPI_FLASH_PAGE_SIZE - 4)
+#define PAGE_DATA_LENGTH (PAGE_CRC_OFFSET - PAGE_HEADER_LENGTH)
+#define RECORD_HEADER_LENGTH 6
+#define ERASED 0xFFFFFFFF
+#define POLL_TICKS TIMER_MS_2_TIMERTICK(1)
+
+#if EVENT_LOG_SIZE % SPI_FLASH_SECTOR_SIZE != 0 || EVENT_LOG_SIZE < 2 * SPI_FLASH_SECTOR_SIZE
+#error EVENT_LOG_SIZE must be at least two whole sectors
+#endif
+/* A record must fit in an empty page after a dropped record */
+#if 2 * RECORD_HEADER_LENGTH + 4 + EVENT_LOG_MAX_DATA > PAGE_DATA_LENGTH
+#error EVENT_LOG_MAX_DATA does not fit in a page
+#endif
+
+static void preparePage(uint8 *page, uint32 sequence);
+
+static bool mounted;
+static bool acquired;
+static bool pollScheduled;
+
+static uint8 pages[EVENT_LOG_BUFFER_PAGES][SPI_FLASH_PAGE_SIZE];
+/* Page numbers are the sequence numbers, which also give the position.
+ * One sector is kept erased ahead of the write position. */
+static SpiFlashWriter writer = {
+	.address = EVENT_LOG_ADDRESS,
+	.regionPages = PAGES,
+	.limit = SPI_FLASH_NO_LIMIT,
+	.eraseAhead = PAGES_PER_SECTOR,
+	.pages = pages,
+	.pageCount = EVENT_LOG_BUFFER_PAGES,
+	.prepare = preparePage,
+};
+/* Record bytes in the buffer being filled */
+static uint16 fillLength;
+static uint32 dropped;
+
+static struct {
+	bool active;
+	bool filling;
+	uint32 next;
+	uint32 end;
+	uint32 pages;
+} readout;
+static uint8 notifyConnection = NO_CONNECTION;
+
+static void notifyStatus(EventLogCommand command, uint32 count) {
+	if (notifyConnection == NO_CONNECTION) {
+		return;
+	}
+	uint8 report[5];
+	report[0] = command;
+	putUint32(&report[1], count);
+	gecko_cmd_gatt_server_send_characteristic_notification(notifyConnection, gattdb_event_log_control, sizeof(report), report);
+}
+
+static void schedulePoll(void) {
+	if (!pollScheduled) {
+		pollScheduled = true;
+		gecko_cmd_hardware_set_soft_timer(POLL_TICKS, AppTimerIDEventLog, true);
+	}
+}
+
+static uint32 readSequence(uint32 page) {
+	uint8 sequence[4];
+	spiFlash_Read(EVENT_LOG_ADDRESS + page * SPI_FLASH_PAGE_SIZE, sequence, sizeof(sequence));
+	return getUint32(sequence);
+}
+
+static void queueFillPage(void) {
+	putUint16(&pages[writer.fillPage][4], fillLength);
+	spiFlash_WriterQueue(&writer);
+	fillLength = 0;
+}
+
+/* The sequence number is only known once the page is programmed */
+static void preparePage(uint8 *page, uint32 sequence) {
+	putUint32(page, sequence);
+	putUint32(&page[PAGE_CRC_OFFSET], crc_Crc32(0, page, PAGE_CRC_OFFSET));
+}
+
+static void appendRecord(uint8 type, const void *data, uint8 len) {
+	uint8 *page = pages[writer.fillPage];
+	if (fillLength == 0) {
+		/* Padding programs nothing */
+		memset(page, 0xFF, SPI_FLASH_PAGE_SIZE);
+	}
+	struct gecko_msg_hardware_get_time_rsp_t *time = gecko_cmd_hardware_get_time();
+	uint8 *record = &page[PAGE_HEADER_LENGTH + fillLength];
+	record[0] = type;
+	record[1] = len;
+	putUint32(&record[2], time->seconds * 1000 + TIMER_TIMERTICK_2_MS(time->ticks));
+	memcpy(&record[RECORD_HEADER_LENGTH], data, len);
+	fillLength += RECORD_HEADER_LENGTH + len;
+}
+
+/* Starts a page, so always fits */
+static void appendDropped(void) {
+	uint8 count[4];
+	putUint32(count, dropped);
+	appendRecord(EventLogTypeDropped, count, sizeof(count));
+	dropped = 0;
+}
+
+void eventLog_Init(void) {
+	spiFlash_Acquire();
+	/* Sequence numbers increase through the region, so the newest sector has the largest first sequence number */
+	uint32 newest = ERASED;
+	uint32 headPage = 0;
+	for (uint32 page = 0; page < PAGES; page += PAGES_PER_SECTOR) {
+		uint32 sequence = readSequence(page);
+		if (sequence != ERASED && sequence % PAGES == page && (newest == ERASED || sequence > newest)) {
+			newest = sequence;
+			headPage = page;
+		}
+	}
+	if (newest == ERASED) {
+		spiFlash_WriterReset(&writer, 0, 0);
+	} else {
+		/* Skip every programmed page in that sector, including any torn by a reset */
+		uint32 used = 1;
+		while (used < PAGES_PER_SECTOR && readSequence(headPage + used) != ERASED) {
+			used++;
+		}
+		spiFlash_WriterReset(&writer, newest + used, newest + PAGES_PER_SECTOR);
+	}
+	spiFlash_Release();
+	mounted = true;
+	LogInfo("Event log at page %lu", writer.written);
+	eventLog_Poll();
+}
+
+void eventLog_Write(uint8 type, const void *data, uint8 len) {
+	if (len > EVENT_LOG_MAX_DATA) {
+		len = EVENT_LOG_MAX_DATA;
+	}
+	if (fillLength + RECORD_HEADER_LENGTH + len > PAGE_DATA_LENGTH) {
+		queueFillPage();
+		schedulePoll();
+	}
+	if (writer.pagesQueued == EVENT_LOG_BUFFER_PAGES) {
+		if (dropped++ == 0) {
+			LogWarn("Event log full, dropping records");
+		}
+		return;
+	}
+	if (fillLength == 0 && dropped > 0) {
+		appendDropped();
+	}
+	appendRecord(type, data, len);
+}
+
+void eventLog_Flush(void) {
+	if (writer.pagesQueued == EVENT_LOG_BUFFER_PAGES) {
+		return;
+	}
+	if (fillLength == 0 && dropped > 0) {
+		appendDropped();
+	}
+	if (fillLength > 0) {
+		queueFillPage();
+		schedulePoll();
+	}
+}
+
+void eventLog_Sync(void) {
+	eventLog_Flush();
+	if (!mounted) {
+		return;
+	}
+	if (!acquired) {
+		spiFlash_Acquire();
+		acquired = true;
+	}
+	while (writer.pagesQueued > 0 || writer.programming) {
+		spiFlash_WriterPump(&writer);
+	}
+	spiFlash_Release();
+	acquired = false;
+}
+
+void eventLog_Poll(void) {
+	pollScheduled = false;
+	if (!mounted || (!acquired && !spiFlash_WriterHasWork(&writer))) {
+		return;
+	}
+	if (!acquired) {
+		spiFlash_Acquire();
+		acquired = true;
+	}
+	bool busy = spiFlash_WriterPump(&writer);
+	if (readout.active && !busy) {
+		/* The read out stops while the flash is busy, and may be waiting for
+		 * a page that is now in the flash, so carry on with it */
+		throughput_Pump();
+	}
+	if (busy) {
+		schedulePoll();
+	} else if (!readout.active) {
+		spiFlash_Release();
+		acquired = false;
+	}
+}
+
+void eventLog_Refill(void) {
+	if (!readout.active || readout.filling) {
+		return;
+	}
+	/* throughput_Write() pumps, which comes back here */
+	readout.filling = true;
+	while (readout.next < readout.end && readout.next < writer.written && throughput_Space() >= SPI_FLASH_PAGE_SIZE && !spiFlash_IsBusy()) {
+		uint8 page[SPI_FLASH_PAGE_SIZE];
+		spiFlash_Read(PAGE_ADDRESS(readout.next), page, sizeof(page));
+		/* Skip pages that were never programmed, or have been erased since */
+		if (getUint32(page) == readout.next) {
+			throughput_Write(page, sizeof(page));
+			readout.pages++;
+		}
+		readout.next++;
+	}
+	readout.filling = false;
+	/* Only report once the last page has been handed to the stack */
+	if (readout.next == readout.end && throughput_Space() == THROUGHPUT_BUFFER_SIZE) {
+		readout.active = false;
+		LogInfo("Event log read out, %lu pages", readout.pages);
+		notifyStatus(EventLogCommandRead, readout.pages);
+		/* Put the flash back to sleep, from the timer as this may be called from eventLog_Poll() */
+		schedulePoll();
+	}
+}
+
+uint8 eventLog_ControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	if (len < 1) {
+		return (uint8) bg_err_att_invalid_att_length;
+	}
+	switch ((EventLogCommand) data[0]) {
+	case EventLogCommandRead:
+		if (!mounted || readout.active) {
+			return (uint8) bg_err_att_request_not_supported;
+		}
+		eventLog_Flush();
+		readout.active = true;
+		/* The sector after the write position has been erased ahead */
+		readout.next = writer.erased > PAGES ? writer.erased - PAGES : 0;
+		readout.end = writer.written + writer.pagesQueued;
+		readout.pages = 0;
+		if (!acquired) {
+			spiFlash_Acquire();
+			acquired = true;
+		}
+		throughput_Pump();
+		break;
+	case EventLogCommandFlush:
+		eventLog_Flush();
+		notifyStatus(EventLogCommandFlush, writer.written + writer.pagesQueued);
+		break;
+	default:
+		return (uint8) bg_err_att_request_not_supported;
+	}
+	return bg_err_success;
+}
+
+void eventLog_ConnectionClosed(uint8 connection) {
+	if (connection == notifyConnection) {
+		notifyConnection = NO_CONNECTION;
+	}
+	/* The stream buffer is emptied when the stream client goes, so the read out is incomplete */
+	if (readout.active) {
+		readout.active = false;
+		schedulePoll();
+	}
+}
+
+void eventLog_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+	if (characteristic == gattdb_event_log_control && status_flags == gatt_server_client_config) {
+		notifyConnection = (client_config_flags & gatt_notification) ? connection : NO_CONNECTION;
+	}
+}
+
+#else
+
+void eventLog_Init(void) {
+}
+
+void eventLog_Write(uint8 type, const void *data, uint8 len) {
+}
+
+void eventLog_Flush(void) {
+}
+
+void eventLog_Sync(void) {
+}
+
+void eventLog_Poll(void) {
+}
+
+void eventLog_Refill(void) {
+}
+
+uint8 eventLog_ControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return (uint8) bg_err_att_request_not_supported;
+}
+
+void eventLog_ConnectionClosed(uint8 connection) {
+}
+
+void eventLog_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+}
+
+#endif /* FEATURE_SPI_FLASH */
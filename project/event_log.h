@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * @file event_log.h
+ * @brief Circular event log in the SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef EVENT_LOG_H_
+#define EVENT_LOG_H_
+
+#include "bg_types.h"
+#include "spi_flash.h"
+
+/* An append only log of what the device did, kept in a circular region of
+ * the SPI flash after the upgrade image slots, so it survives faults and
+ * resets.
+ *
+ * Records are collected in page sized RAM buffers and a page is only
+ * programmed once it is full, or when flushed. Full pages are programmed in
+ * the background while the next page fills, and the sector after the write
+ * position is erased ahead of time, which drops the oldest sector. The flash
+ * is woken for each burst and put back into deep power down afterwards.
+ *
+ * Each page is
+ *   <uint32 sequence> <uint16 length> <length bytes of records, 0xFF padded> <uint32 crc32>
+ * where the page is at (sequence % pages) in the region and the CRC covers
+ * everything before it. Each record is
+ *   <uint8 type> <uint8 length> <uint32 milliseconds since boot> <length bytes of data>
+ * and records never span pages. tools/event_log.py decodes a read out.
+ *
+ * Writing to the event log control characteristic:
+ *   0x01 - read out: flush, then send every stored page, oldest first, on
+ *          the stream characteristic. Stream notifications must be enabled.
+ *   0x02 - flush the partly filled page
+ * Completion is notified on the event log control characteristic as
+ *   <uint8 command> <uint32 pages>
+ *
+ * Only available on boards with FEATURE_SPI_FLASH.
+ */
+
+/** Start of the log region. Must not overlap the upgrade image slots. */
+#ifndef EVENT_LOG_ADDRESS
+#define EVENT_LOG_ADDRESS (SPI_FLASH_IMAGE_SLOT_ADDRESS + SPI_FLASH_IMAGE_SLOTS * SPI_FLASH_IMAGE_SLOT_SIZE)
+#endif
+
+/** Size of the log region, a whole number of sectors, at least two. */
+#ifndef EVENT_LOG_SIZE
+#define EVENT_LOG_SIZE 0x20000
+#endif
+
+/** Number of page sized RAM buffers. Records are dropped while they are all waiting to be programmed. */
+#ifndef EVENT_LOG_BUFFER_PAGES
+#define EVENT_LOG_BUFFER_PAGES 2
+#endif
+
+/** Longest record data. */
+#ifndef EVENT_LOG_MAX_DATA
+#define EVENT_LOG_MAX_DATA 32
+#endif
+
+typedef enum {
+	/** <uint8 warm> */
+	EventLogTypeBoot = 0x01,
+	/** <uint8 connection> <bd_addr address> */
+	EventLogTypeConnectionOpened = 0x02,
+	/** <uint8 connection> <uint16 reason> */
+	EventLogTypeConnectionClosed = 0x03,
+	/** <uint8 button> <uint8 output> */
+	EventLogTypeButton = 0x04,
+	/** No data */
+	EventLogTypeHibernate = 0x05,
+	/** <uint32 records dropped since the last record> */
+	EventLogTypeDropped = 0x06,
+} EventLogType;
+
+typedef enum {
+	EventLogCommandRead = 0x01,
+	EventLogCommandFlush = 0x02,
+} EventLogCommand;
+
+/***************************************************************************//**
+ * @brief
+ *   Find the write position in the flash. Records written before this are
+ *   kept in RAM until it is called.
+ ******************************************************************************/
+void eventLog_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Add a record to the log.
+ *
+ * @param[in] type
+ *   The record type, an EventLogType.
+ *
+ * @param[in] data
+ *   The record data.
+ *
+ * @param[in] len
+ *   Number of bytes in @p data, truncated to EVENT_LOG_MAX_DATA.
+ ******************************************************************************/
+void eventLog_Write(uint8 type, const void *data, uint8 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Program the partly filled page in the background.
+ ******************************************************************************/
+void eventLog_Flush(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Program every buffered record before returning, e.g. before losing RAM.
+ ******************************************************************************/
+void eventLog_Sync(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Progress programming and erasing. Call when the AppTimerIDEventLog timer fires.
+ ******************************************************************************/
+void eventLog_Poll(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Queue pages of a read out on the stream. Call from throughput_Refill().
+ ******************************************************************************/
+void eventLog_Refill(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Handle a write to the event log control characteristic.
+ *
+ * @return
+ *   The ATT error code for the write response.
+ ******************************************************************************/
+uint8 eventLog_ControlWrite(uint8 connection, uint8 len, const uint8 *data);
+
+/* Event hooks, call from the matching gecko events */
+void eventLog_ConnectionClosed(uint8 connection);
+void eventLog_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags);
+
+#endif /* EVENT_LOG_H_ */
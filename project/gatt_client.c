@@ -0,0 +1,274 @@
+/*****************************************************************************
+ * @file gatt_client.c
+ * @brief GATT client discovery with a persistent handle cache
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "gatt_client.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "crc.h"
+#include "logging.h"
+
+#define NO_BONDING 0xFF
+#define FNV_OFFSET 2166136261UL
+#define FNV_PRIME 16777619UL
+
+typedef enum {
+	ClientStateIdle = 0,
+	ClientStateDiscoveringService,
+	ClientStateDiscoveringCharacteristics,
+	ClientStateReady,
+	ClientStateFailed
+} ClientState;
+
+typedef struct {
+	ClientState state;
+	uint8 bonding;
+	bool busy;
+	uint16 result;
+	uint32 service;
+	uint16 handles[GATT_CLIENT_MAX_CHARACTERISTICS];
+} ClientConnection;
+
+/* PS key record */
+typedef struct {
+	uint32 profileHash;
+	uint16 handles[GATT_CLIENT_MAX_CHARACTERISTICS];
+	/* CRC-32 of the fields above */
+	uint32 crc;
+} CacheRecord;
+
+#define RECORD_CRC_LENGTH (sizeof(CacheRecord) - sizeof(uint32))
+
+static const GattClientUUID *profileService;
+static const GattClientUUID *profileCharacteristics;
+static uint8 profileCount;
+static uint32 profileHash;
+static ClientConnection connections[GATT_CLIENT_MAX_CONNECTIONS];
+
+static uint32 hashUUID(uint32 hash, const GattClientUUID *uuid) {
+	hash = (hash ^ uuid->len) * FNV_PRIME;
+	for (uint8 i = 0; i < uuid->len; i++) {
+		hash = (hash ^ uuid->uuid[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+static ClientConnection *connectionFor(uint8 connection) {
+	if (connection == 0 || connection > GATT_CLIENT_MAX_CONNECTIONS) {
+		return NULL;
+	}
+	return &connections[connection - 1];
+}
+
+static bool uuidEqual(const GattClientUUID *a, const uint8array *b) {
+	return a->len == b->len && memcmp(a->uuid, b->data, a->len) == 0;
+}
+
+static bool loadCache(ClientConnection *c) {
+	if (c->bonding == NO_BONDING) {
+		return false;
+	}
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(GATT_CLIENT_PS_KEY_BASE + c->bonding);
+	CacheRecord record;
+	if (rsp->result != bg_err_success || rsp->value.len != sizeof(record)) {
+		return false;
+	}
+	memcpy(&record, rsp->value.data, sizeof(record));
+	if (record.crc != crc_Crc32(0, &record, RECORD_CRC_LENGTH) || record.profileHash != profileHash) {
+		return false;
+	}
+	memcpy(c->handles, record.handles, sizeof(c->handles));
+	return true;
+}
+
+static void saveCache(ClientConnection *c) {
+	if (c->bonding == NO_BONDING || c->state != ClientStateReady) {
+		return;
+	}
+	CacheRecord record;
+	record.profileHash = profileHash;
+	memcpy(record.handles, c->handles, sizeof(record.handles));
+	record.crc = crc_Crc32(0, &record, RECORD_CRC_LENGTH);
+	uint16 result = gecko_cmd_flash_ps_save(GATT_CLIENT_PS_KEY_BASE + c->bonding, sizeof(record), (const uint8 *) &record)->result;
+	if (result != bg_err_success) {
+		LogWarn("Could not save GATT handle cache: 0x%x", result);
+	}
+}
+
+static void finish(uint8 connection, ClientConnection *c, uint16 result, bool cached) {
+	c->state = result == bg_err_success ? ClientStateReady : ClientStateFailed;
+	c->result = result;
+	if (!cached) {
+		saveCache(c);
+	}
+	if (gattClient_Ready) {
+		gattClient_Ready(connection, result, c->handles, cached);
+	}
+}
+
+static void startDiscovery(uint8 connection, ClientConnection *c) {
+	memset(c->handles, 0, sizeof(c->handles));
+	c->service = 0;
+	uint16 result = gecko_cmd_gatt_discover_primary_services_by_uuid(connection, profileService->len, profileService->uuid)->result;
+	if (result != bg_err_success) {
+		finish(connection, c, result, false);
+		return;
+	}
+	c->state = ClientStateDiscoveringService;
+	c->busy = true;
+}
+
+void gattClient_Init(const GattClientUUID *service, const GattClientUUID *characteristics, uint8 count) {
+	if (count > GATT_CLIENT_MAX_CHARACTERISTICS) {
+		count = GATT_CLIENT_MAX_CHARACTERISTICS;
+	}
+	profileService = service;
+	profileCharacteristics = characteristics;
+	profileCount = count;
+	profileHash = hashUUID(FNV_OFFSET, service);
+	for (uint8 i = 0; i < count; i++) {
+		profileHash = hashUUID(profileHash, &characteristics[i]);
+	}
+}
+
+const uint16 *gattClient_Handles(uint8 connection) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || c->state != ClientStateReady) {
+		return NULL;
+	}
+	return c->handles;
+}
+
+bool gattClient_IsBusy(uint8 connection) {
+	ClientConnection *c = connectionFor(connection);
+	return c && c->busy;
+}
+
+void gattClient_Invalidate(uint8 connection) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || !profileService || c->busy) {
+		return;
+	}
+	if (c->bonding != NO_BONDING) {
+		gecko_cmd_flash_ps_erase(GATT_CLIENT_PS_KEY_BASE + c->bonding);
+	}
+	startDiscovery(connection, c);
+}
+
+void gattClient_ConnectionOpened(uint8 connection, uint8 bonding) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || !profileService) {
+		return;
+	}
+	memset(c, 0, sizeof(*c));
+	c->bonding = bonding;
+	if (loadCache(c)) {
+		LogInfo("GATT handles for bonding %d loaded from cache", bonding);
+		finish(connection, c, bg_err_success, true);
+	} else {
+		startDiscovery(connection, c);
+	}
+}
+
+void gattClient_ConnectionClosed(uint8 connection) {
+	ClientConnection *c = connectionFor(connection);
+	if (c) {
+		c->state = ClientStateIdle;
+		c->busy = false;
+	}
+}
+
+void gattClient_Bonded(uint8 connection, uint8 bonding) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || c->bonding == bonding) {
+		return;
+	}
+	c->bonding = bonding;
+	/* A new bond can reuse the slot of an old one, whose handles must not be
+	 * served to this peer if discovery hasn't finished to replace them */
+	gecko_cmd_flash_ps_erase(GATT_CLIENT_PS_KEY_BASE + bonding);
+	/* Discovery may have finished before the bond was made */
+	saveCache(c);
+}
+
+void gattClient_Service(uint8 connection, uint32 service, const uint8array *uuid) {
+	ClientConnection *c = connectionFor(connection);
+	if (c && c->state == ClientStateDiscoveringService && uuidEqual(profileService, uuid)) {
+		c->service = service;
+	}
+}
+
+void gattClient_Characteristic(uint8 connection, uint16 characteristic, const uint8array *uuid) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || c->state != ClientStateDiscoveringCharacteristics) {
+		return;
+	}
+	for (uint8 i = 0; i < profileCount; i++) {
+		if (uuidEqual(&profileCharacteristics[i], uuid)) {
+			c->handles[i] = characteristic;
+			return;
+		}
+	}
+}
+
+bool gattClient_ProcedureCompleted(uint8 connection, uint16 result) {
+	ClientConnection *c = connectionFor(connection);
+	if (!c || !c->busy) {
+		return false;
+	}
+	c->busy = false;
+	if (result != bg_err_success) {
+		finish(connection, c, result, false);
+		return true;
+	}
+	switch (c->state) {
+	case ClientStateDiscoveringService:
+		if (c->service == 0) {
+			finish(connection, c, bg_err_att_att_not_found, false);
+			break;
+		}
+		result = gecko_cmd_gatt_discover_characteristics(connection, c->service)->result;
+		if (result != bg_err_success) {
+			finish(connection, c, result, false);
+			break;
+		}
+		c->state = ClientStateDiscoveringCharacteristics;
+		c->busy = true;
+		break;
+	case ClientStateDiscoveringCharacteristics:
+		finish(connection, c, bg_err_success, false);
+		break;
+	default:
+		break;
+	}
+	return true;
+}
@@ -0,0 +1,143 @@
+/*****************************************************************************
+ * @file gatt_client.h
+ * @brief GATT client discovery with a persistent handle cache
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef GATT_CLIENT_H_
+#define GATT_CLIENT_H_
+
+#include "bg_types.h"
+
+/* Discovers one service and a list of its characteristics on the remote
+ * device of each connection. Discovery is a state machine with one GATT
+ * procedure in flight per connection; connections are discovered
+ * concurrently.
+ *
+ * When the peer is bonded the discovered handles are saved in a PS key for
+ * that bonding, so reconnections to a known peer skip discovery and are ready
+ * as soon as the connection opens. The cache is tagged with a hash of the
+ * profile UUIDs, so changing the profile invalidates it.
+ */
+
+/** Maximum number of characteristics in the profile. */
+#ifndef GATT_CLIENT_MAX_CHARACTERISTICS
+#define GATT_CLIENT_MAX_CHARACTERISTICS 8
+#endif
+
+/** Maximum connection handle. */
+#ifndef GATT_CLIENT_MAX_CONNECTIONS
+#define GATT_CLIENT_MAX_CONNECTIONS 4
+#endif
+
+/** First PS key of the handle cache. The key for a bonding is this plus the bonding handle. */
+#ifndef GATT_CLIENT_PS_KEY_BASE
+#define GATT_CLIENT_PS_KEY_BASE 0x4010
+#endif
+
+/** A 16 or 128 bit UUID in little endian byte order, as in the GATT events. */
+typedef struct {
+	uint8 len;
+	uint8 uuid[16];
+} GattClientUUID;
+
+/** A handle that was not found. */
+#define GATT_CLIENT_HANDLE_INVALID 0
+
+/***************************************************************************//**
+ * @brief
+ *   Set the service and characteristics to discover on each connection.
+ *
+ * @param[in] service
+ *   The service UUID.
+ *
+ * @param[in] characteristics
+ *   The characteristic UUIDs. The handles are reported in the same order.
+ *
+ * @param[in] count
+ *   The number of characteristics, at most GATT_CLIENT_MAX_CHARACTERISTICS.
+ ******************************************************************************/
+void gattClient_Init(const GattClientUUID *service, const GattClientUUID *characteristics, uint8 count);
+
+/***************************************************************************//**
+ * @brief
+ *   Get the handles for a connection, or NULL if discovery is not complete.
+ ******************************************************************************/
+const uint16 *gattClient_Handles(uint8 connection);
+
+/***************************************************************************//**
+ * @brief
+ *   True if a procedure started by the client is in progress on the connection.
+ *   Only start other GATT procedures when this is false.
+ ******************************************************************************/
+bool gattClient_IsBusy(uint8 connection);
+
+/***************************************************************************//**
+ * @brief
+ *   Forget the cached handles for a connection and discover again, e.g. after
+ *   an ATT invalid handle error.
+ ******************************************************************************/
+void gattClient_Invalidate(uint8 connection);
+
+/* Event hooks, call from the matching gecko events */
+void gattClient_ConnectionOpened(uint8 connection, uint8 bonding);
+void gattClient_ConnectionClosed(uint8 connection);
+void gattClient_Bonded(uint8 connection, uint8 bonding);
+void gattClient_Service(uint8 connection, uint32 service, const uint8array *uuid);
+void gattClient_Characteristic(uint8 connection, uint16 characteristic, const uint8array *uuid);
+
+/***************************************************************************//**
+ * @brief
+ *   Call from gecko_evt_gatt_procedure_completed().
+ *
+ * @return
+ *   True if the procedure was started by the client, false if it belongs to the application.
+ ******************************************************************************/
+bool gattClient_ProcedureCompleted(uint8 connection, uint16 result);
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you should implement to use the discovered handles.
+ *
+ * @param[in] connection
+ *   The connection.
+ *
+ * @param[in] result
+ *   bg_err_success, or the error that stopped discovery.
+ *
+ * @param[in] handles
+ *   The characteristic handles in profile order, GATT_CLIENT_HANDLE_INVALID if not found.
+ *
+ * @param[in] cached
+ *   True if the handles were loaded from the cache instead of discovered.
+ ******************************************************************************/
+void gattClient_Ready(uint8 connection, uint16 result, const uint16 *handles, bool cached) __attribute__((weak));
+
+#endif /* GATT_CLIENT_H_ */
@@ -43,11 +43,112 @@ GATT_DATA(const uint8_t bg_gattdb_data_uuidtable_128_map [])=
 {
 0xf0, 0x19, 0x21, 0xb4, 0x47, 0x8f, 0xa4, 0xbf, 0xa1, 0x4f, 0x63, 0xfd, 0xee, 0xd6, 0x14, 0x1d, 
 0x63, 0x60, 0x32, 0xe0, 0x37, 0x5e, 0xa4, 0x88, 0x53, 0x4e, 0x6d, 0xfb, 0x64, 0x35, 0xbf, 0xf7, 
+0xb3, 0xda, 0x92, 0x59, 0xf9, 0x40, 0xaf, 0x90, 0xf0, 0x44, 0xc9, 0x1e, 0x28, 0x23, 0x87, 0x6b, 
+0x00, 0x9a, 0xf6, 0xae, 0xcb, 0xea, 0x09, 0x86, 0x20, 0x4a, 0x3c, 0xd8, 0xd7, 0x13, 0x39, 0xbf, 
+0x4f, 0x47, 0xc5, 0x76, 0x15, 0xe8, 0x02, 0x81, 0xb9, 0x48, 0x71, 0xb3, 0xe3, 0xfc, 0x42, 0x17, 
+0x10, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
+0x11, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
+0x12, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
+0x13, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
+0x14, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
+0x15, 0x8a, 0x6f, 0x5e, 0x2d, 0x7c, 0x1a, 0x9b, 0x8e, 0x4f, 0x4c, 0x3d, 0x2f, 0x6a, 0x1b, 0x0e, 
 };
 
 
 
 
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_40 ) = {
+	.properties=0x02,
+	.index=10,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_39 ) = {
+	.len=19,
+	.data={0x02,0x29,0x00,0x15,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_37 ) = {
+	.properties=0x18,
+	.index=9,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_36 ) = {
+	.len=19,
+	.data={0x18,0x26,0x00,0x14,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_34 ) = {
+	.properties=0x1a,
+	.index=8,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_33 ) = {
+	.len=19,
+	.data={0x1a,0x23,0x00,0x13,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_32 ) = {
+	.properties=0x02,
+	.index=7,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_31 ) = {
+	.len=19,
+	.data={0x02,0x21,0x00,0x12,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_29 ) = {
+	.properties=0x18,
+	.index=6,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_28 ) = {
+	.len=19,
+	.data={0x18,0x1e,0x00,0x11,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_27 ) = {
+	.properties=0x04,
+	.index=5,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_26 ) = {
+	.len=19,
+	.data={0x04,0x1c,0x00,0x10,0x8a,0x6f,0x5e,0x2d,0x7c,0x1a,0x9b,0x8e,0x4f,0x4c,0x3d,0x2f,0x6a,0x1b,0x0e,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_24 ) = {
+	.properties=0x18,
+	.index=4,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_23 ) = {
+	.len=19,
+	.data={0x18,0x19,0x00,0x4f,0x47,0xc5,0x76,0x15,0xe8,0x02,0x81,0xb9,0x48,0x71,0xb3,0xe3,0xfc,0x42,0x17,}
+};
+GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_21 ) = {
+	.properties=0x14,
+	.index=3,
+	.max_len=0,
+	.data=NULL,
+};
+
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_20 ) = {
+	.len=19,
+	.data={0x14,0x16,0x00,0x00,0x9a,0xf6,0xae,0xcb,0xea,0x09,0x86,0x20,0x4a,0x3c,0xd8,0xd7,0x13,0x39,0xbf,}
+};
+GATT_DATA(const struct bg_gattdb_buffer_with_len	bg_gattdb_data_attribute_field_19 ) = {
+	.len=16,
+	.data={0xb3,0xda,0x92,0x59,0xf9,0x40,0xaf,0x90,0xf0,0x44,0xc9,0x1e,0x28,0x23,0x87,0x6b,}
+};
 GATT_DATA(const struct bg_gattdb_attribute_chrvalue	bg_gattdb_data_attribute_field_18 ) = {
 	.properties=0x08,
 	.index=2,
@@ -151,24 +252,54 @@ GATT_DATA(const struct bg_gattdb_attribute bg_gattdb_data_attributes_map[])={
     {.uuid=0x0000,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_16},
     {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_17},
     {.uuid=0x8001,.permissions=0x802,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_18},
+    {.uuid=0x0000,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_19},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_20},
+    {.uuid=0x8003,.permissions=0x804,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_21},
+    {.uuid=0x000c,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x03,.clientconfig_index=0x01}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_23},
+    {.uuid=0x8004,.permissions=0x802,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_24},
+    {.uuid=0x000c,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x04,.clientconfig_index=0x02}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_26},
+    {.uuid=0x8005,.permissions=0x804,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_27},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_28},
+    {.uuid=0x8006,.permissions=0x802,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_29},
+    {.uuid=0x000c,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x06,.clientconfig_index=0x03}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_31},
+    {.uuid=0x8007,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_32},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_33},
+    {.uuid=0x8008,.permissions=0x803,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_34},
+    {.uuid=0x000c,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x08,.clientconfig_index=0x04}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_36},
+    {.uuid=0x8009,.permissions=0x802,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_37},
+    {.uuid=0x000c,.permissions=0x807,.caps=0xffff,.datatype=0x03,.min_key_size=0x00,.configdata={.flags=0x01,.index=0x09,.clientconfig_index=0x05}},
+    {.uuid=0x0002,.permissions=0x801,.caps=0xffff,.datatype=0x00,.min_key_size=0x00,.constdata=&bg_gattdb_data_attribute_field_39},
+    {.uuid=0x800a,.permissions=0x801,.caps=0xffff,.datatype=0x07,.min_key_size=0x00,.dynamicdata=&bg_gattdb_data_attribute_field_40},
 };
 
 GATT_DATA(const uint16_t bg_gattdb_data_attributes_dynamic_mapping_map[])={
 	0x0003,
 	0x0007,
 	0x0013,
+	0x0016,
+	0x0019,
+	0x001c,
+	0x001e,
+	0x0021,
+	0x0023,
+	0x0026,
+	0x0029,
 };
 
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid16_map[])={0x0};
 GATT_DATA(const uint8_t bg_gattdb_data_adv_uuid128_map[])={0x0};
 GATT_HEADER(const struct bg_gattdb_def bg_gattdb_data)={
     .attributes=bg_gattdb_data_attributes_map,
-    .attributes_max=19,
+    .attributes_max=41,
     .uuidtable_16_size=13,
     .uuidtable_16=bg_gattdb_data_uuidtable_16_map,
-    .uuidtable_128_size=2,
+    .uuidtable_128_size=11,
     .uuidtable_128=bg_gattdb_data_uuidtable_128_map,
-    .attributes_dynamic_max=3,
+    .attributes_dynamic_max=11,
     .attributes_dynamic_mapping=bg_gattdb_data_attributes_dynamic_mapping_map,
     .adv_uuid16=bg_gattdb_data_adv_uuid16_map,
     .adv_uuid16_num=0,
@@ -16,5 +16,13 @@ extern const struct bg_gattdb_def bg_gattdb_data;
 #define gattdb_service_changed_char             3
 #define gattdb_device_name                      7
 #define gattdb_ota_control                     19
+#define gattdb_stream                          22
+#define gattdb_stream_control                  25
+#define gattdb_image_data                      28
+#define gattdb_image_control                   30
+#define gattdb_telemetry_key                   33
+#define gattdb_press_count                     35
+#define gattdb_event_log_control               38
+#define gattdb_ram_status                      41
 
 #endif
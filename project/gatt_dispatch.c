@@ -0,0 +1,92 @@
+/*****************************************************************************
+ * @file gatt_dispatch.c
+ * @brief Table driven dispatch of user GATT reads and writes
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "gatt_dispatch.h"
+#include "gatt_handlers.h"
+#include "value_cache.h"
+#include "prepared_write.h"
+#include "logging.h"
+
+static const GattUserHandler *handlerFor(uint16 characteristic) {
+	/* Handles below the first wrap round to a large index */
+	uint16 index = characteristic - GATT_HANDLERS_FIRST;
+	if (index >= GATT_HANDLERS_COUNT) {
+		return NULL;
+	}
+	return &gattHandlers[index];
+}
+
+void gattDispatch_Read(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset) {
+	if (valueCache_Read(connection, characteristic, offset)) {
+		return;
+	}
+	const GattUserHandler *handler = handlerFor(characteristic);
+	if (!handler || !handler->read) {
+		gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, (uint8) bg_err_att_request_not_supported, 0, NULL);
+		return;
+	}
+	handler->read(connection, offset);
+}
+
+void gattDispatch_Write(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset, const uint8array *value) {
+	const GattUserHandler *handler = handlerFor(characteristic);
+	uint8 result;
+	if (!handler || !handler->write) {
+		result = (uint8) bg_err_att_request_not_supported;
+	} else if (att_opcode == gatt_prepare_write_request) {
+		/* Handed over in one piece when the queue is executed */
+		result = preparedWrite_Queue(connection, characteristic, handler->maxLength, offset, value->len, value->data);
+	} else if (offset != 0) {
+		result = (uint8) bg_err_att_invalid_offset;
+	} else if (value->len > handler->maxLength) {
+		result = (uint8) bg_err_att_invalid_att_length;
+	} else {
+		result = handler->write(connection, value->len, value->data);
+	}
+	if (att_opcode != gatt_write_command) {
+		gecko_cmd_gatt_server_send_user_write_response(connection, characteristic, result);
+	}
+}
+
+static void deliver(uint8 connection, uint16 characteristic, uint16 len, const uint8 *data) {
+	uint8 result = handlerFor(characteristic)->write(connection, len, data);
+	if (result != bg_err_success) {
+		/* The execute write has already been answered */
+		LogWarn("Long write of characteristic %d failed: 0x%02x", characteristic, result);
+	}
+}
+
+void gattDispatch_ExecuteWrite(uint8 connection, uint16 result) {
+	/* Dropped if the client cancelled the queue or it failed */
+	preparedWrite_Execute(connection, result == bg_err_success, deliver);
+}
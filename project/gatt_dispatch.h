@@ -0,0 +1,80 @@
+/*****************************************************************************
+ * @file gatt_dispatch.h
+ * @brief Table driven dispatch of user GATT reads and writes
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef GATT_DISPATCH_H_
+#define GATT_DISPATCH_H_
+
+#include <stddef.h>
+#include "bg_types.h"
+#include "native_gecko.h"
+
+/* Reads and writes of user type characteristics go through a table indexed
+ * by attribute handle, generated from gatt.xml and gatt_db.h into
+ * gatt_handlers.c and gatt_handlers.h by tools/gatt_dispatch.py. Run it again
+ * whenever gatt.xml changes:
+ *
+ *   tools/gatt_dispatch.py gatt.xml gatt_db.h gatt_handlers.c gatt_handlers.h
+ *
+ * For a characteristic with id "press_count" the table refers to
+ * gattUser_PressCountRead() if it can be read and gattUser_PressCountWrite()
+ * if it can be written. Both are weak, so only the ones needed are
+ * implemented. A request to a characteristic without a handler is answered
+ * with request not supported. Reads of cached values (see value_cache.h) are
+ * answered from the cache, without a read handler.
+ *
+ * Writes longer than the declared value length, or at an offset, are rejected
+ * before the handler runs. Handlers of characteristics written without
+ * response still return a result, which is dropped.
+ *
+ * Long writes are queued fragment by fragment in prepared_write.c and reach
+ * the write handler once, as a whole value, when the client executes them.
+ * The execute write has already been answered then, so a failure is only
+ * logged. Writable values are at most 255 bytes, the longest a handler takes.
+ */
+
+typedef void (*GattReadHandler)(uint8 connection, uint16 offset);
+typedef uint8 (*GattWriteHandler)(uint8 connection, uint8 len, const uint8 *data);
+
+typedef struct {
+	GattReadHandler read;
+	GattWriteHandler write;
+	/* Declared value length, the longest write accepted */
+	uint16 maxLength;
+} GattUserHandler;
+
+/* Event hooks, called from the corresponding gecko events */
+void gattDispatch_Read(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset);
+void gattDispatch_Write(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset, const uint8array *value);
+void gattDispatch_ExecuteWrite(uint8 connection, uint16 result);
+
+#endif /* GATT_DISPATCH_H_ */
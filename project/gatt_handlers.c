@@ -0,0 +1,18 @@
+/********************************************************************
+ * Generated by tools/gatt_dispatch.py from gatt.xml, do not edit.
+ *******************************************************************/
+
+#include "gatt_handlers.h"
+#include "gatt_db.h"
+
+const GattUserHandler gattHandlers[GATT_HANDLERS_COUNT] = {
+	[gattdb_ota_control - GATT_HANDLERS_FIRST] = { NULL, gattUser_OtaControlWrite, 1 },
+	[gattdb_stream - GATT_HANDLERS_FIRST] = { NULL, gattUser_StreamWrite, 244 },
+	[gattdb_stream_control - GATT_HANDLERS_FIRST] = { NULL, gattUser_StreamControlWrite, 16 },
+	[gattdb_image_data - GATT_HANDLERS_FIRST] = { NULL, gattUser_ImageDataWrite, 244 },
+	[gattdb_image_control - GATT_HANDLERS_FIRST] = { NULL, gattUser_ImageControlWrite, 16 },
+	[gattdb_telemetry_key - GATT_HANDLERS_FIRST] = { gattUser_TelemetryKeyRead, NULL, 16 },
+	[gattdb_press_count - GATT_HANDLERS_FIRST] = { gattUser_PressCountRead, gattUser_PressCountWrite, 4 },
+	[gattdb_event_log_control - GATT_HANDLERS_FIRST] = { NULL, gattUser_EventLogControlWrite, 16 },
+	[gattdb_ram_status - GATT_HANDLERS_FIRST] = { gattUser_RamStatusRead, NULL, 13 },
+};
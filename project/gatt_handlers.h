@@ -0,0 +1,35 @@
+/********************************************************************
+ * Generated by tools/gatt_dispatch.py from gatt.xml, do not edit.
+ *******************************************************************/
+
+#ifndef GATT_HANDLERS_H
+#define GATT_HANDLERS_H
+
+#include "gatt_dispatch.h"
+
+#define GATT_HANDLERS_FIRST 19
+#define GATT_HANDLERS_COUNT 23
+
+extern const GattUserHandler gattHandlers[GATT_HANDLERS_COUNT];
+
+/* ota_control */
+uint8 gattUser_OtaControlWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* stream */
+uint8 gattUser_StreamWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* stream_control */
+uint8 gattUser_StreamControlWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* image_data */
+uint8 gattUser_ImageDataWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* image_control */
+uint8 gattUser_ImageControlWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* telemetry_key */
+void gattUser_TelemetryKeyRead(uint8 connection, uint16 offset) __attribute__((weak));
+/* press_count */
+void gattUser_PressCountRead(uint8 connection, uint16 offset) __attribute__((weak));
+uint8 gattUser_PressCountWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* event_log_control */
+uint8 gattUser_EventLogControlWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));
+/* ram_status */
+void gattUser_RamStatusRead(uint8 connection, uint16 offset) __attribute__((weak));
+
+#endif
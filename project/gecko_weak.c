@@ -35,7 +35,7 @@
 #include "gecko_weak_handler.h"
 #include "native_gecko.h"
 
-void gecko_evt_handle(struct gecko_cmd_packet* evt) {
+RAM_CODE void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 	switch (BGLIB_MSG_ID(evt->header)) {
 		case gecko_evt_dfu_boot_id: {
 			struct gecko_msg_dfu_boot_evt_t* data = &evt->data.evt_dfu_boot;
@@ -63,7 +63,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_le_gap_scan_response_id: {
 			struct gecko_msg_le_gap_scan_response_evt_t* data = &evt->data.evt_le_gap_scan_response;
-			gecko_evt_le_gap_scan_response(data->rssi, data->packet_type, data->address, data->address_type, data->bonding, data->data);
+			gecko_evt_le_gap_scan_response(data->rssi, data->packet_type, data->address, data->address_type, data->bonding, &data->data);
 		} break;
 		case gecko_evt_le_gap_adv_timeout_id: {
 			// no data struct with this name: struct gecko_msg_le_gap_adv_timeout_evt_t* data = &evt->data.evt_le_gap_adv_timeout;
@@ -103,23 +103,23 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_gatt_service_id: {
 			struct gecko_msg_gatt_service_evt_t* data = &evt->data.evt_gatt_service;
-			gecko_evt_gatt_service(data->connection, data->service, data->uuid);
+			gecko_evt_gatt_service(data->connection, data->service, &data->uuid);
 		} break;
 		case gecko_evt_gatt_characteristic_id: {
 			struct gecko_msg_gatt_characteristic_evt_t* data = &evt->data.evt_gatt_characteristic;
-			gecko_evt_gatt_characteristic(data->connection, data->characteristic, data->properties, data->uuid);
+			gecko_evt_gatt_characteristic(data->connection, data->characteristic, data->properties, &data->uuid);
 		} break;
 		case gecko_evt_gatt_descriptor_id: {
 			struct gecko_msg_gatt_descriptor_evt_t* data = &evt->data.evt_gatt_descriptor;
-			gecko_evt_gatt_descriptor(data->connection, data->descriptor, data->uuid);
+			gecko_evt_gatt_descriptor(data->connection, data->descriptor, &data->uuid);
 		} break;
 		case gecko_evt_gatt_characteristic_value_id: {
 			struct gecko_msg_gatt_characteristic_value_evt_t* data = &evt->data.evt_gatt_characteristic_value;
-			gecko_evt_gatt_characteristic_value(data->connection, data->characteristic, data->att_opcode, data->offset, data->value);
+			gecko_evt_gatt_characteristic_value(data->connection, data->characteristic, data->att_opcode, data->offset, &data->value);
 		} break;
 		case gecko_evt_gatt_descriptor_value_id: {
 			struct gecko_msg_gatt_descriptor_value_evt_t* data = &evt->data.evt_gatt_descriptor_value;
-			gecko_evt_gatt_descriptor_value(data->connection, data->descriptor, data->offset, data->value);
+			gecko_evt_gatt_descriptor_value(data->connection, data->descriptor, data->offset, &data->value);
 		} break;
 		case gecko_evt_gatt_procedure_completed_id: {
 			struct gecko_msg_gatt_procedure_completed_evt_t* data = &evt->data.evt_gatt_procedure_completed;
@@ -127,7 +127,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_gatt_server_attribute_value_id: {
 			struct gecko_msg_gatt_server_attribute_value_evt_t* data = &evt->data.evt_gatt_server_attribute_value;
-			gecko_evt_gatt_server_attribute_value(data->connection, data->attribute, data->att_opcode, data->offset, data->value);
+			gecko_evt_gatt_server_attribute_value(data->connection, data->attribute, data->att_opcode, data->offset, &data->value);
 		} break;
 		case gecko_evt_gatt_server_user_read_request_id: {
 			struct gecko_msg_gatt_server_user_read_request_evt_t* data = &evt->data.evt_gatt_server_user_read_request;
@@ -135,7 +135,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_gatt_server_user_write_request_id: {
 			struct gecko_msg_gatt_server_user_write_request_evt_t* data = &evt->data.evt_gatt_server_user_write_request;
-			gecko_evt_gatt_server_user_write_request(data->connection, data->characteristic, data->att_opcode, data->offset, data->value);
+			gecko_evt_gatt_server_user_write_request(data->connection, data->characteristic, data->att_opcode, data->offset, &data->value);
 		} break;
 		case gecko_evt_gatt_server_characteristic_status_id: {
 			struct gecko_msg_gatt_server_characteristic_status_evt_t* data = &evt->data.evt_gatt_server_characteristic_status;
@@ -151,7 +151,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_endpoint_data_id: {
 			struct gecko_msg_endpoint_data_evt_t* data = &evt->data.evt_endpoint_data;
-			gecko_evt_endpoint_data(data->endpoint, data->data);
+			gecko_evt_endpoint_data(data->endpoint, &data->data);
 		} break;
 		case gecko_evt_endpoint_status_id: {
 			struct gecko_msg_endpoint_status_evt_t* data = &evt->data.evt_endpoint_status;
@@ -163,7 +163,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_flash_ps_key_id: {
 			struct gecko_msg_flash_ps_key_evt_t* data = &evt->data.evt_flash_ps_key;
-			gecko_evt_flash_ps_key(data->key, data->value);
+			gecko_evt_flash_ps_key(data->key, &data->value);
 		} break;
 		case gecko_evt_test_dtm_completed_id: {
 			struct gecko_msg_test_dtm_completed_evt_t* data = &evt->data.evt_test_dtm_completed;
@@ -171,7 +171,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_test_hcidump_id: {
 			struct gecko_msg_test_hcidump_evt_t* data = &evt->data.evt_test_hcidump;
-			gecko_evt_test_hcidump(data->time, data->direction, data->packet_type, data->data);
+			gecko_evt_test_hcidump(data->time, data->direction, data->packet_type, &data->data);
 		} break;
 		case gecko_evt_sm_passkey_display_id: {
 			struct gecko_msg_sm_passkey_display_evt_t* data = &evt->data.evt_sm_passkey_display;
@@ -207,7 +207,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_homekit_setupcode_display_id: {
 			struct gecko_msg_homekit_setupcode_display_evt_t* data = &evt->data.evt_homekit_setupcode_display;
-			gecko_evt_homekit_setupcode_display(data->connection, data->setupcode);
+			gecko_evt_homekit_setupcode_display(data->connection, &data->setupcode);
 		} break;
 		case gecko_evt_homekit_paired_id: {
 			struct gecko_msg_homekit_paired_evt_t* data = &evt->data.evt_homekit_paired;
@@ -231,7 +231,7 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_homekit_write_request_id: {
 			struct gecko_msg_homekit_write_request_evt_t* data = &evt->data.evt_homekit_write_request;
-			gecko_evt_homekit_write_request(data->connection, data->characteristic, data->chr_value_size, data->authorization_size, data->value_offset, data->value);
+			gecko_evt_homekit_write_request(data->connection, data->characteristic, data->chr_value_size, data->authorization_size, data->value_offset, &data->value);
 		} break;
 		case gecko_evt_homekit_read_request_id: {
 			struct gecko_msg_homekit_read_request_evt_t* data = &evt->data.evt_homekit_read_request;
@@ -243,24 +243,35 @@ void gecko_evt_handle(struct gecko_cmd_packet* evt) {
 		} break;
 		case gecko_evt_homekit_pairing_removed_id: {
 			struct gecko_msg_homekit_pairing_removed_evt_t* data = &evt->data.evt_homekit_pairing_removed;
-			gecko_evt_homekit_pairing_removed(data->connection, data->remaining_pairings, data->pairing_id);
+			gecko_evt_homekit_pairing_removed(data->connection, data->remaining_pairings, &data->pairing_id);
 		} break;
 		case gecko_evt_user_message_to_host_id: {
 			struct gecko_msg_user_message_to_host_evt_t* data = &evt->data.evt_user_message_to_host;
-			gecko_evt_user_message_to_host(data->data);
+			gecko_evt_user_message_to_host(&data->data);
 		} break;
 	}
 }
 
 void gecko_evt_loop() {
+	bool idleWork = true;
 	while (1) {
 		/* Event pointer for handling events */
 		struct gecko_cmd_packet* evt;
 
-		/* Check for stack event. */
-		evt = gecko_wait_event();
+		if (idleWork && gecko_evt_idle) {
+			/* Don't sleep while there is idle work, but handle events first */
+			evt = gecko_peek_event();
+			if (!evt) {
+				idleWork = gecko_evt_idle();
+				continue;
+			}
+		} else {
+			/* Check for stack event. */
+			evt = gecko_wait_event();
+		}
 
 		gecko_evt_handle(evt);
+		idleWork = true;
 	}
 }
 
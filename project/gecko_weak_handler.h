@@ -36,8 +36,14 @@
 
 #include "native_gecko.h"
 #include "gecko_weak.h"
+#include "ram_code.h"
 
-void gecko_evt_handle(struct gecko_cmd_packet* evt);
+/* Run from RAM, see ram_code.h */
+RAM_CODE void gecko_evt_handle(struct gecko_cmd_packet* evt);
+
+/* Called when no event is waiting, while it returns true. The loop waits for
+ * events as usual once it returns false, and calls it again after the next event. */
+bool gecko_evt_idle(void) __attribute__((weak));
 
 void gecko_evt_loop();
 
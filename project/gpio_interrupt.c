@@ -34,6 +34,7 @@
 #include <gpio_interrupt.h>
 #include "em_gpio.h"
 #include "native_gecko.h"
+#include "ram_code.h"
 #include "stdio.h"
 
 #define NUMBER_OF_INTERRUPTS 16
@@ -46,7 +47,7 @@ static GPIO_Port_TypeDef interruptPorts[NUMBER_OF_INTERRUPTS];
 static unsigned int interruptPins[NUMBER_OF_INTERRUPTS];
 
 
-static bool pinForInterrupt(int interrupt, GPIO_Port_TypeDef *port, int *pin) {
+RAM_CODE static bool pinForInterrupt(int interrupt, GPIO_Port_TypeDef *port, int *pin) {
 	if(interrupt < 0 || interrupt > NUMBER_OF_INTERRUPTS || !interruptInUse[interrupt]) {
 		return false;
 	}
@@ -128,6 +129,10 @@ bool gpio_IntSetEnabled(GPIO_Port_TypeDef port, unsigned int pin, bool enabled)
 	return true;
 }
 
+int gpio_IntNumber(GPIO_Port_TypeDef port, unsigned int pin) {
+	return interruptForPin(port, pin);
+}
+
 void gpio_IntRemoveUsage(GPIO_Port_TypeDef port, unsigned int pin) {
 	int interrupt = interruptForPin(port, pin);
 	if (interrupt == -1) {
@@ -139,7 +144,7 @@ void gpio_IntRemoveUsage(GPIO_Port_TypeDef port, unsigned int pin) {
 /**
 * Handle GPIO interrupts and trigger system_external_signal event
 */
-void GPIO_ODD_IRQHandler()
+RAM_CODE void GPIO_ODD_IRQHandler()
 {
   uint32_t flags = GPIO_IntGetEnabled() & 0x0000AAAA;
   GPIO_IntClear(flags);
@@ -150,7 +155,7 @@ void GPIO_ODD_IRQHandler()
 /**
 * Handle GPIO interrupts and trigger system_external_signal event
 */
-void GPIO_EVEN_IRQHandler()
+RAM_CODE void GPIO_EVEN_IRQHandler()
 {
   uint32_t flags = GPIO_IntGetEnabled() & 0x00005555;
   GPIO_IntClear(flags);
@@ -180,7 +185,7 @@ void gpio_get_port_pin_from_interrupt(int interruptNumber, GPIO_Port_TypeDef *po
 #endif
 }
 
-void gecko_evt_system_external_signal(uint32 extsignals) {
+RAM_CODE void gecko_evt_system_external_signal(uint32 extsignals) {
 	if((extsignals & GPIO_signal_key) == 0) {
 		gecko_evt_system_external_signal_non_gpio(extsignals);
 		return;
@@ -112,6 +112,22 @@ void gpio_IntClear(GPIO_Port_TypeDef port, unsigned int pin);
  ******************************************************************************/
 bool gpio_IntSetEnabled(GPIO_Port_TypeDef port, unsigned int pin, bool enabled);
 
+/***************************************************************************//**
+ * @brief
+ *   Get the interrupt number configured for a pin. GPIO PRS signal n follows
+ *   the pin routed to interrupt n, so this is also the PRS signal for the pin.
+ *
+ * @param[in] port
+ *   The port to associate with @p pin.
+ *
+ * @param[in] pin
+ *   The pin number on the port.
+ *
+ * @return
+ *   The interrupt number, or -1 if no interrupt has been configured for this port/pin using gpio_IntConfig().
+ ******************************************************************************/
+int gpio_IntNumber(GPIO_Port_TypeDef port, unsigned int pin);
+
 /***************************************************************************//**
  * @brief
  *   Mark a pin as unused, freeing an interrupt for use on other pins.
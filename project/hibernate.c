@@ -0,0 +1,137 @@
+/*****************************************************************************
+ * @file hibernate.c
+ * @brief EM4 hibernation with retained state
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "hibernate.h"
+#include "em_device.h"
+#include "em_emu.h"
+#include "em_gpio.h"
+#include "em_rmu.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "InitDevice.h"
+#include "app_timer.h"
+#include "crc.h"
+#include "logging.h"
+
+#define MAGIC 0x48424E31
+#define RETAINED_WORDS 3
+#define NUMBER_OF_BUTTONS 4
+
+static const GPIO_Port_TypeDef ports[NUMBER_OF_BUTTONS] = { BUTTON_LED0_PORT, BUTTON_LED1_PORT, BUTTON_LED2_PORT, BUTTON_LED3_PORT };
+static const unsigned int pins[NUMBER_OF_BUTTONS] = { BUTTON_LED0_PIN, BUTTON_LED1_PIN, BUTTON_LED2_PIN, BUTTON_LED3_PIN };
+
+static uint8 connections;
+
+static void startTimer(void) {
+#if HIBERNATE_TIMEOUT > 0
+	gecko_cmd_hardware_set_soft_timer(HIBERNATE_TIMEOUT * TIMER_CLK_FREQ, AppTimerIDHibernate, true);
+#endif
+}
+
+static void retain(const HibernateState *state) {
+	uint32 words[RETAINED_WORDS];
+	words[0] = MAGIC;
+	words[1] = state->buttons | (state->joystick << 8);
+	words[2] = state->pressCount;
+	for (int i = 0; i < RETAINED_WORDS; i++) {
+		RTCC->RET[i].REG = words[i];
+	}
+	RTCC->RET[RETAINED_WORDS].REG = crc_Crc32(0, words, sizeof(words));
+}
+
+static void enterEm4(void) {
+	/* LEDs off, and the wake up button must be an input */
+	for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
+		GPIO_PinModeSet(ports[i], pins[i], gpioModeInput, 1);
+	}
+	EMU_EM4Init_TypeDef init = EMU_EM4INIT_DEFAULT;
+	init.em4State = emuEM4Hibernate;
+	/* Hold every pin as it is, which keeps the display powered down */
+	init.pinRetentionMode = emuPinRetentionLatch;
+	EMU_EM4Init(&init);
+	GPIO_EM4EnablePinWakeup(HIBERNATE_WAKE_PINS, 0);
+	LogInfo("Hibernating");
+	EMU_EnterEM4H();
+}
+
+bool hibernate_Restore(HibernateState *state) {
+	uint32 cause = RMU_ResetCauseGet();
+	RMU_ResetCauseClear();
+	if (!(cause & RMU_RSTCAUSE_EM4RST)) {
+		return false;
+	}
+	uint32 words[RETAINED_WORDS];
+	for (int i = 0; i < RETAINED_WORDS; i++) {
+		words[i] = RTCC->RET[i].REG;
+	}
+	if (words[0] != MAGIC || RTCC->RET[RETAINED_WORDS].REG != crc_Crc32(0, words, sizeof(words))) {
+		return false;
+	}
+	/* Only restore once */
+	RTCC->RET[0].REG = 0;
+	state->buttons = words[1] & 0xFF;
+	state->joystick = (words[1] >> 8) & 0xFF;
+	state->pressCount = words[2];
+	return true;
+}
+
+void hibernate_Init(void) {
+	/* The pins have been configured again, so they can follow their registers */
+	EMU_UnlatchPinRetention();
+	startTimer();
+}
+
+void hibernate_Activity(void) {
+	startTimer();
+}
+
+void hibernate_ConnectionOpened(void) {
+	connections++;
+}
+
+void hibernate_ConnectionClosed(void) {
+	if (connections > 0) {
+		connections--;
+	}
+	startTimer();
+}
+
+void hibernate_Timeout(void) {
+	HibernateState state = { 0 };
+	if (connections > 0 || !hibernate_Save || !hibernate_Save(&state)) {
+		startTimer();
+		return;
+	}
+	retain(&state);
+	enterEm4();
+}
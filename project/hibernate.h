@@ -0,0 +1,117 @@
+/*****************************************************************************
+ * @file hibernate.h
+ * @brief EM4 hibernation with retained state
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef HIBERNATE_H_
+#define HIBERNATE_H_
+
+#include "bg_types.h"
+
+/* After HIBERNATE_TIMEOUT seconds without user activity or connections the
+ * device enters EM4 hibernate, its lowest power mode short of shutoff. RAM is
+ * lost, so the application state is kept in the RTCC retention registers,
+ * and the GPIO state is latched.
+ *
+ * EXTCOMIN stops toggling in EM4 and there is no limit on how long the device
+ * stays there, so hibernate_Save() must blank and power down the memory LCD
+ * rather than leave an image on it.
+ *
+ * Pressing the button on the EM4 wake up pin (PF7, EM4WU1) resets the device.
+ * main() sees the EM4 reset, restores the retained state and takes the warm
+ * boot path. The display is drawn again in full, with the retained state
+ * already applied.
+ */
+
+/** Seconds of inactivity before hibernating. 0 disables hibernation. */
+#ifndef HIBERNATE_TIMEOUT
+#define HIBERNATE_TIMEOUT 1800
+#endif
+
+/** EM4 wake up pins, as GPIO_EXTILEVEL_EM4WUn bits. Woken when they go low. */
+#ifndef HIBERNATE_WAKE_PINS
+#define HIBERNATE_WAKE_PINS GPIO_EXTILEVEL_EM4WU1
+#endif
+
+typedef struct {
+	/** Bit n set when button n drives its LED */
+	uint8 buttons;
+	/** JoystickDirection */
+	uint8 joystick;
+	uint32 pressCount;
+} HibernateState;
+
+/***************************************************************************//**
+ * @brief
+ *   Check for a wake up from EM4 and get the retained state. Call from main()
+ *   once the peripherals are initialised.
+ *
+ * @param[out] state
+ *   Receives the state saved before hibernating.
+ *
+ * @return
+ *   True for a warm boot with valid retained state.
+ ******************************************************************************/
+bool hibernate_Restore(HibernateState *state);
+
+/***************************************************************************//**
+ * @brief
+ *   Release the pins latched during hibernation and start the inactivity
+ *   timer. Call once the pins have been configured again.
+ ******************************************************************************/
+void hibernate_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Restart the inactivity timer. Call on any user activity.
+ ******************************************************************************/
+void hibernate_Activity(void);
+
+/* Event hooks, called from the corresponding gecko events */
+void hibernate_ConnectionOpened(void);
+void hibernate_ConnectionClosed(void);
+void hibernate_Timeout(void);
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you should implement to provide the state to retain.
+ *   Before returning true, put anything that can't be left unattended, such
+ *   as the display, into a safe state.
+ *
+ * @param[out] state
+ *   The state to retain.
+ *
+ * @return
+ *   True to hibernate, false to stay awake for another timeout.
+ ******************************************************************************/
+bool hibernate_Save(HibernateState *state) __attribute__((weak));
+
+#endif /* HIBERNATE_H_ */
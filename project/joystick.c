@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * @file joystick.c
+ * @brief Joystick reading with comparator wake up
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "joystick.h"
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_adc.h"
+#include "em_acmp.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "logging.h"
+
+static bool polling;
+static uint32 lastActive;
+
+static JoystickDirection directionForSample(uint32 sample) {
+	if (sample < 50) {
+		return JoystickDirectionCenter;
+	} else if (sample < 2040) {
+		return JoystickDirectionS;
+	} else if (sample < 2450) {
+		return JoystickDirectionW;
+	} else if (sample < 3130) {
+		return JoystickDirectionE;
+	} else if (sample < 3505) {
+		return JoystickDirectionN;
+	}
+	return JoystickDirectionNone;
+}
+
+static uint32 sampleAdc(void) {
+	ADC_Start(ADC0, adcStartSingle);
+	while ((ADC0->IF & ADC_IF_SINGLE) == 0)
+		;
+	return ADC_DataSingleGet(ADC0);
+}
+
+static void startPolling(void) {
+	polling = true;
+	lastActive = appTimerNow();
+	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(JOYSTICK_POLL_INTERVAL), AppTimerIDADCRead, false);
+}
+
+#if JOYSTICK_LOW_POWER
+/* Hand over to the comparator. Fails if the joystick is already deflected, as there would be no edge to wake on. */
+static bool armWake(void) {
+	ACMP_Enable(ACMP0);
+	while ((ACMP0->STATUS & ACMP_STATUS_ACMPACT) == 0)
+		;
+	ACMP_IntClear(ACMP0, ACMP_IF_EDGE);
+	if ((ACMP0->STATUS & ACMP_STATUS_ACMPOUT) == 0) {
+		ACMP_Disable(ACMP0);
+		return false;
+	}
+	/* An edge since the flag was cleared interrupts as soon as this is enabled */
+	ACMP_IntEnable(ACMP0, ACMP_IEN_EDGE);
+	return true;
+}
+
+void ACMP0_IRQHandler(void) {
+	uint32 flags = ACMP_IntGet(ACMP0);
+	ACMP_IntClear(ACMP0, flags);
+	ACMP_IntDisable(ACMP0, ACMP_IEN_EDGE);
+	gecko_external_signal(JOYSTICK_WAKE_SIGNAL);
+}
+#endif
+
+void joystick_Init(void) {
+#if JOYSTICK_LOW_POWER
+	CMU_ClockEnable(cmuClock_ACMP0, true);
+	ACMP_Init_TypeDef init = ACMP_INIT_DEFAULT;
+	init.enable = false;
+	/* The joystick pulls the line down from VDD when deflected */
+	init.interruptOnFallingEdge = true;
+	init.interruptOnRisingEdge = false;
+	ACMP_Init(ACMP0, &init);
+	ACMP_VAConfig_TypeDef va = ACMP_VACONFIG_DEFAULT;
+	va.input = acmpVAInputVDD;
+	va.div0 = JOYSTICK_WAKE_DIVIDER;
+	va.div1 = JOYSTICK_WAKE_DIVIDER;
+	ACMP_VASetup(ACMP0, &va);
+	/* Same APORT channel as the ADC input */
+	ACMP_ChannelSet(ACMP0, acmpInputVADIV, acmpInputAPORT3XCH8);
+	NVIC_ClearPendingIRQ(ACMP0_IRQn);
+	NVIC_EnableIRQ(ACMP0_IRQn);
+#endif
+	startPolling();
+}
+
+JoystickDirection joystick_Read(void) {
+	JoystickDirection direction = directionForSample(sampleAdc());
+	uint32 now = appTimerNow();
+	if (direction != JoystickDirectionNone) {
+		lastActive = now;
+	}
+#if JOYSTICK_LOW_POWER
+	else if (polling && now - lastActive >= TIMER_MS_2_TIMERTICK(JOYSTICK_IDLE_TIMEOUT) && armWake()) {
+		polling = false;
+		gecko_cmd_hardware_set_soft_timer(TIMER_STOP, AppTimerIDADCRead, false);
+	}
+#endif
+	return direction;
+}
+
+void joystick_Wake(void) {
+#if JOYSTICK_LOW_POWER
+	ACMP_Disable(ACMP0);
+#endif
+	if (!polling) {
+		startPolling();
+	}
+}
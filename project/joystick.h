@@ -21,4 +21,52 @@ typedef enum {
 	JoystickDirectionNW,
 } JoystickDirection;
 
+/* The joystick is a resistor ladder read by ADC0. In low power mode the ADC
+ * is only polled while the joystick is in use: once it has been released for
+ * JOYSTICK_IDLE_TIMEOUT, polling stops and ACMP0 watches the line against
+ * JOYSTICK_WAKE_DIVIDER in EM2, waking the system on the next deflection.
+ */
+
+/** Set to 0 to poll the ADC all the time. */
+#ifndef JOYSTICK_LOW_POWER
+#define JOYSTICK_LOW_POWER 1
+#endif
+
+/** ADC poll interval in milliseconds while the joystick is in use. */
+#ifndef JOYSTICK_POLL_INTERVAL
+#define JOYSTICK_POLL_INTERVAL 250
+#endif
+
+/** Milliseconds released before polling stops. */
+#ifndef JOYSTICK_IDLE_TIMEOUT
+#define JOYSTICK_IDLE_TIMEOUT 2000
+#endif
+
+/** ACMP0 wakes when the line falls below VDD * (JOYSTICK_WAKE_DIVIDER + 1) / 64, just above the N direction. */
+#ifndef JOYSTICK_WAKE_DIVIDER
+#define JOYSTICK_WAKE_DIVIDER 54
+#endif
+
+/** External signal raised by a deflection. Must not overlap the GPIO signals. */
+#define JOYSTICK_WAKE_SIGNAL 0x00020000
+
+/***************************************************************************//**
+ * @brief
+ *   Configure ACMP0 and start polling. Call from gecko_evt_system_boot().
+ ******************************************************************************/
+void joystick_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Read the direction from the ADC, and stop polling if the joystick has been
+ *   idle long enough. Call from the AppTimerIDADCRead soft timer.
+ ******************************************************************************/
+JoystickDirection joystick_Read(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Start polling again after a deflection. Call on JOYSTICK_WAKE_SIGNAL.
+ ******************************************************************************/
+void joystick_Wake(void);
+
 #endif /* JOYSTICK_H_ */
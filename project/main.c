@@ -13,6 +13,8 @@
  * any purpose, you must agree to the terms of that agreement.
  **************************************************************************************************/
 
+#include <string.h>
+
 /* Board headers */
 #include "boards.h"
 #include "ble-configuration.h"
@@ -45,9 +47,30 @@
 #include "gecko_weak_handler.h"
 #include "gpio_interrupt.h"
 #include "app_timer.h"
-#include "em_adc.h"
 #include "joystick.h"
 #include "graphics.h"
+#include "display_polarity.h"
+#include "throughput.h"
+#include "advertising.h"
+#include "broadcast.h"
+#include "observer.h"
+#include "gatt_client.h"
+#include "reconnect.h"
+#include "upgrade.h"
+#include "crc.h"
+#include "aes_ccm.h"
+#include "telemetry.h"
+#include "press_count.h"
+#include "hibernate.h"
+#include "boot.h"
+#include "event_log.h"
+#include "persist.h"
+#include "ram_monitor.h"
+#include "gatt_dispatch.h"
+#include "gatt_handlers.h"
+#include "prepared_write.h"
+#include "work.h"
+#include "coroutine.h"
 
 /***********************************************************************************************//**
  * @addtogroup Application
@@ -77,9 +100,22 @@ static const gecko_configuration_t config = { .config_flags = 0, .sleep.flags =
 #endif
 		};
 
+/* Accessories are expected to expose the Battery Service with a Battery Level characteristic */
+static const GattClientUUID accessoryService = { 2, { 0x0F, 0x18 } };
+static const GattClientUUID accessoryCharacteristics[] = { { 2, { 0x19, 0x2A } } };
+
 /* Flag for indicating DFU Reset must be performed */
 uint8_t boot_to_dfu = 0;
 
+/* State retained while hibernating, valid when woken from EM4 */
+static HibernateState retained;
+static bool warmBoot;
+static JoystickDirection joystickDirection = JoystickDirectionNone;
+/* The display is brought up after advertising has started */
+static bool displayReady;
+
+static void restoreRetainedState(void);
+
 #ifndef FEATURE_IOEXPANDER
 /* Periodically called Display Polarity Inverter Function for the LCD.
 Toggles the the EXTCOMIN signal of the Sharp memory LCD panel, which prevents building up a DC
@@ -91,6 +127,8 @@ static void (*dispPolarityInvert)(void *);
  * @brief  Main function
  */
 int main(void) {
+	boot_Start();
+
 #ifdef FEATURE_SPI_FLASH
 	/* Put the SPI flash into Deep Power Down mode for those radio boards where it is available */
 	MX25_init();
@@ -105,6 +143,14 @@ int main(void) {
 
 	RETARGET_SwoInit();
 
+	/* Woken from hibernation, so take the warm boot path */
+	warmBoot = hibernate_Restore(&retained);
+	boot_SetWarm(warmBoot);
+	boot_Mark(BootStageDevice);
+
+	/* Paint the stack and heap for their peaks, and guard the stack limit */
+	ramMonitor_Init(bluetooth_stack_heap, sizeof(bluetooth_stack_heap));
+
 	/* Enable GPIO_EVEN interrupt vector in NVIC */
 	NVIC_ClearPendingIRQ(GPIO_ODD_IRQn);
 	NVIC_EnableIRQ(GPIO_ODD_IRQn);
@@ -119,15 +165,44 @@ int main(void) {
 
 	/* Initialize stack */
 	gecko_init(&config);
+	boot_Mark(BootStageStack);
 
 	/* Enter main event loop */
 	gecko_evt_loop();
 }
 
+/* True while a button is driving its LED */
+static bool states[] = {false, false, false, false};
+
+#ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
+/* Drawn from the work queue, so a redraw never delays events */
+static uint8 redrawButtons;
+static bool redrawJoystick;
+
+static void redrawDisplay(void) {
+	graphSetUpdatesDeferred(true);
+	if (redrawJoystick) {
+		graphSetJoystickDirection(joystickDirection);
+	}
+	for (int i = 0; i < 4; i++) {
+		if (redrawButtons & (1 << i)) {
+			graphSetButtonState(i, states[i]);
+		}
+	}
+	redrawButtons = 0;
+	redrawJoystick = false;
+	graphSetUpdatesDeferred(false);
+}
+
+static WorkItem redrawWork = WORK_ITEM(redrawDisplay, "redraw", WorkPriorityLow);
+#endif
+
+/* Writes of changed PS values, which can stall for a page erase */
+static WorkItem persistWork = WORK_ITEM(persist_Flush, "persist", WorkPriorityLow);
+
 void toggleState(int num) {
 	static const GPIO_Port_TypeDef ports[] = {BUTTON_LED0_PORT, BUTTON_LED1_PORT, BUTTON_LED2_PORT, BUTTON_LED3_PORT};
 	static const int pins[] = {BUTTON_LED0_PIN, BUTTON_LED1_PIN, BUTTON_LED2_PIN, BUTTON_LED3_PIN};
-	static bool states[] = {false, false, false, false};
 	if(num > 3) {
 		return;
 	}
@@ -145,12 +220,23 @@ void toggleState(int num) {
 		GPIO_PinModeSet(ports[num], pins[num], gpioModePushPull, 0);
 	}
 	states[num] = !states[num];
+	broadcast_SetButtonState(num, states[num]);
+	uint8 record[] = { num, states[num] };
+	eventLog_Write(EventLogTypeButton, record, sizeof(record));
 #ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
-	graphSetButtonState(num, states[num]);
+	/* Changes while the display is being initialised are redrawn once it is ready */
+	redrawButtons |= 1 << num;
+	if (displayReady) {
+		work_Post(&redrawWork);
+	}
 #endif
 }
 
 void gpio_IntEvent(GPIO_Port_TypeDef port, unsigned int pin, bool state) {
+	/* Someone is at the device, so make it quick to find */
+	advertising_UserActivity();
+	hibernate_Activity();
+
 	if (port == BUTTON_LED0_PORT && pin == BUTTON_LED0_PIN) {
 		toggleState(1);
 	} else if (port == BUTTON_LED1_PORT && pin == BUTTON_LED1_PIN) {
@@ -162,78 +248,216 @@ void gpio_IntEvent(GPIO_Port_TypeDef port, unsigned int pin, bool state) {
 	}
 }
 
+void pressCount_WillStart(void) {
+	/* Buttons can only be counted as inputs */
+	for (int i = 0; i < 4; i++) {
+		if (states[i]) {
+			toggleState(i);
+		}
+	}
+}
+
+void gecko_evt_system_external_signal_non_gpio(uint32 extsignals) {
+	if (extsignals & PRESS_COUNT_SIGNAL) {
+		pressCount_Signal();
+	}
+	if (extsignals & JOYSTICK_WAKE_SIGNAL) {
+		/* Someone is at the device, so make it quick to find */
+		advertising_UserActivity();
+		hibernate_Activity();
+		joystick_Wake();
+	}
+	/* WORK_SIGNAL needs nothing, the work queue runs after any event */
+}
+
 /** GECKO EVENTS **/
 
-/* This boot event is generated when the system boots up after reset.
- * Here the system is set to start advertising immediately after boot procedure. */
-void gecko_evt_system_boot(uint16 major, uint16 minor, uint16 patch, uint16 build, uint32 bootloader, uint16 hw) {
 #ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
+static uint8 drawButton;
+
+/* Drawn a part per slice so events are handled in between */
+static CoroutineStatus initDisplay(Coroutine *co) {
+	CO_BEGIN(co);
+	/* Draw the whole state, including any retained state, in one display update */
+	graphSetUpdatesDeferred(true);
+	redrawButtons = 0;
+	redrawJoystick = false;
+
 	/* Initialise the graphics */
 	graphInit();
-	graphSetJoystickDirection(JoystickDirectionNone);
-
-	graphSetButtonState(0, false);
-	graphSetButtonState(1, false);
-	graphSetButtonState(2, false);
-	graphSetButtonState(3, false);
 
 	/* Disable Joystick pin – enabled due to a bug in the display library */
 	GPIO_PinModeSet(gpioPortA, 0, gpioModeDisabled, 0);
-#endif
+	CO_YIELD(co);
+
+	graphSetJoystickDirection(joystickDirection);
+	for (drawButton = 0; drawButton < 4; drawButton++) {
+		CO_YIELD(co);
+		graphSetButtonState(drawButton, states[drawButton]);
+	}
+
+	displayReady = true;
+	graphSetUpdatesDeferred(false);
+	if (redrawButtons || redrawJoystick) {
+		work_Post(&redrawWork);
+	}
+	CO_END(co);
+}
 
-	/* Set advertising parameters. 100ms advertisement interval. All channels used.
-	 * The first two parameters are minimum and maximum advertising interval, both in
-	 * units of (milliseconds * 1.6). The third parameter '7' sets advertising on all channels. */
-	gecko_cmd_le_gap_set_adv_parameters(160, 160, 7);
+static Coroutine displayInit = COROUTINE(initDisplay, "display");
 
-	/* Start general advertising and enable connections. */
-	gecko_cmd_le_gap_set_mode(le_gap_general_discoverable, le_gap_undirected_connectable);
+static void startDisplay(void) {
+	coroutine_Start(&displayInit);
+}
+#endif
 
-	/* Start reading ADC 4 times a second */
-	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(250), AppTimerIDADCRead, false);
+static void initJoystick(void) {
+	/* Start reading ADC 4 times a second, until the joystick is left alone */
+	joystick_Init();
 
 	/* Update now */
 	gecko_evt_hardware_soft_timer(AppTimerIDADCRead);
 }
 
+static void initSelfTests(void) {
+	/* Hardware CRC for image and record checks, software until then */
+	crc_Init();
+
+	/* Check the CRYPTO peripheral used for sealed telemetry, nothing is sealed until it passes */
+	telemetry_SelfTested(aesCcm_Init());
+}
+
+bool gecko_evt_idle(void) {
+	ramMonitor_Sample();
+	return work_Run();
+}
+
+/* This boot event is generated when the system boots up after reset.
+ * Only what is needed to be discoverable and connectable runs here, so
+ * advertising starts as soon as possible. The rest is deferred. */
+void gecko_evt_system_boot(uint16 major, uint16 minor, uint16 patch, uint16 build, uint32 bootloader, uint16 hw) {
+	boot_Mark(BootStageSystemBoot);
+
+	/* Kept in RAM until the log is found in the flash */
+	uint8 warm = warmBoot;
+	eventLog_Write(EventLogTypeBoot, &warm, sizeof(warm));
+
+	/* Request the largest MTU for bulk transfers */
+	throughput_Init();
+
+	/* Enable bonding and cache the known peers */
+	reconnect_Init();
+
+	/* Record an upgrade that has just been installed as the next delta reference */
+	upgrade_Init();
+
+	/* Load the telemetry key and count this boot, before anything is sealed */
+	telemetry_Init();
+
+	/* Carry on counting from the total kept before the reset */
+	pressCount_Init();
+
+	/* Put the initial panel state in the advertising data */
+	broadcast_Init();
+
+	/* Advertise the retained state from the first advertisement */
+	if (warmBoot) {
+		restoreRetainedState();
+	}
+
+	/* Discover the accessory profile on each connection */
+	gattClient_Init(&accessoryService, accessoryCharacteristics, sizeof(accessoryCharacteristics) / sizeof(accessoryCharacteristics[0]));
+
+	/* Start general advertising and enable connections, fast at first then slowing down. */
+	advertising_Start();
+	boot_Mark(BootStageDiscoverable);
+
+#ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
+	boot_Defer(startDisplay, "display");
+#endif
+	boot_Defer(initJoystick, "joystick");
+
+#if OBSERVER_ENABLED
+	/* Listen for other advertisers, only reporting new or changed ones */
+	boot_Defer(observer_Start, "observer");
+#endif
+
+	boot_Defer(initSelfTests, "self tests");
+
+	/* Find the write position in the event log */
+	boot_Defer(eventLog_Init, "event log");
+
+	/* Hibernate after a long time without activity, once every pin is configured */
+	boot_Defer(hibernate_Init, "hibernate");
+
+	/* Stack and heap used by boot */
+	boot_Defer(ramMonitor_Report, "RAM report");
+}
+
 void handleJoystickRead(JoystickDirection direction) {
-	static JoystickDirection previousDirection = JoystickDirectionNone;
-	if(direction == previousDirection) { return; }
-	previousDirection = direction;
+	if(direction == joystickDirection) { return; }
+	joystickDirection = direction;
+	hibernate_Activity();
 	LogInfo("New joystick direction: %d", direction);
+	broadcast_SetJoystickDirection(direction);
+#ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
+	redrawJoystick = true;
+	if (displayReady) {
+		work_Post(&redrawWork);
+	}
+#endif
+}
+
+static void restoreRetainedState(void) {
+	LogInfo("Restoring retained state");
+	for (int i = 0; i < 4; i++) {
+		if (retained.buttons & (1 << i)) {
+			toggleState(i);
+		}
+	}
+	handleJoystickRead(retained.joystick);
+	pressCount_Restore(retained.pressCount);
+}
+
+bool hibernate_Save(HibernateState *state) {
+	/* Presses can't be counted in EM4 */
+	if (pressCount_Enabled()) {
+		return false;
+	}
+	for (int i = 0; i < 4; i++) {
+		if (states[i]) {
+			state->buttons |= 1 << i;
+		}
+	}
+	state->joystick = joystickDirection;
+	state->pressCount = pressCount_Total();
+
+	/* RAM is lost in EM4 */
+	eventLog_Write(EventLogTypeHibernate, NULL, 0);
+	eventLog_Sync();
+	persist_Sync();
 #ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
-	graphSetJoystickDirection(direction);
+	/* EXTCOMIN stops in EM4, so don't leave an image on the panel */
+	if (displayReady) {
+		graphSleep();
+	}
 #endif
+	return true;
 }
 
 void gecko_evt_hardware_soft_timer(uint8 handle) {
 	switch ((AppTimerID) handle) {
 	case AppTimerIDStop: break;
-	case AppTimerIDADCRead:
-		/* Start reading */
-		ADC_Start(ADC0, adcStartSingle);
-		/* Wait until it's read */
-		while ((ADC0->IF & ADC_IF_SINGLE) == 0)
-			;
-		/* Get ADC single result */
-		uint32_t sample = ADC_DataSingleGet(ADC0);
-
-		/* Get the joystick direction from ADC reading */
-		JoystickDirection d = JoystickDirectionNone;
-		if(sample < 50) {
-			d = JoystickDirectionCenter;
-		} else if(sample < 2040) {
-			d = JoystickDirectionS;
-		} else if(sample < 2450) {
-			d = JoystickDirectionW;
-		} else if(sample < 3130) {
-			d = JoystickDirectionE;
-		} else if(sample < 3505) {
-			d = JoystickDirectionN;
+	case AppTimerIDADCRead: {
+		/* Read the joystick direction from the ADC */
+		JoystickDirection direction = joystick_Read();
+		/* Pressing the joystick lets a new client bond */
+		if (direction == JoystickDirectionCenter && direction != joystickDirection) {
+			reconnect_AllowBonding();
 		}
-		handleJoystickRead(d);
-
+		handleJoystickRead(direction);
 		break;
+	}
 #ifndef FEATURE_IOEXPANDER
 	case AppTimerIDDispPolInv:
 	  /*Toggle the the EXTCOMIN signal, which prevents building up a DC bias  within the
@@ -241,38 +465,233 @@ void gecko_evt_hardware_soft_timer(uint8 handle) {
 	  dispPolarityInvert(0);
 	  break;
 #endif /* FEATURE_IOEXPANDER */
+	case AppTimerIDThroughputPump:
+		throughput_Pump();
+		break;
+	case AppTimerIDObserverAge:
+#if OBSERVER_ENABLED
+		observer_AgeTick();
+#endif
+		break;
+	case AppTimerIDReconnect:
+		reconnect_Timeout();
+		break;
+	case AppTimerIDPairing:
+		reconnect_PairingTimeout();
+		break;
+	case AppTimerIDHibernate:
+		hibernate_Timeout();
+		break;
+	case AppTimerIDUpgrade:
+		upgrade_Poll();
+		break;
+	case AppTimerIDEventLog:
+		eventLog_Poll();
+		break;
+	case AppTimerIDPersist:
+		work_Post(&persistWork);
+		break;
+	case AppTimerIDCoroutine:
+		coroutine_Timer();
+		break;
+	case AppTimerIDAdvertising:
+		advertising_Timeout();
+		break;
 	}
 }
 
+void gecko_evt_le_connection_opened(bd_addr address, uint8 address_type, uint8 master, uint8 connection, uint8 bonding) {
+	advertising_ConnectionOpened();
+	reconnect_ConnectionOpened(address, address_type, connection, bonding);
+	throughput_ConnectionOpened(connection);
+	gattClient_ConnectionOpened(connection, bonding);
+	telemetry_ConnectionOpened(connection);
+	hibernate_ConnectionOpened();
+
+	uint8 record[1 + sizeof(bd_addr)];
+	record[0] = connection;
+	memcpy(&record[1], address.addr, sizeof(bd_addr));
+	eventLog_Write(EventLogTypeConnectionOpened, record, sizeof(record));
+}
+
+void gecko_evt_le_connection_parameters(uint8 connection, uint16 interval, uint16 latency, uint16 timeout, uint8 security_mode, uint16 txsize) {
+	telemetry_ConnectionParameters(connection, security_mode);
+}
+
+void gecko_evt_le_gap_scan_response(int8 rssi, uint8 packet_type, bd_addr address, uint8 address_type, uint8 bonding, const uint8array *data) {
+#if OBSERVER_ENABLED
+	observer_ScanResponse(rssi, packet_type, address, address_type, data->len, data->data);
+#endif
+}
+
+void gecko_evt_le_gap_scan_request(uint8 handle, bd_addr address, uint8 address_type, uint8 bonding) {
+	broadcast_ScanRequest();
+}
+
+/* Show or clear the passkey the peer enters to bond */
+static void showPasskey(uint32 passkey, bool shown) {
+#ifdef GRAPHICS_H // ifdef so you can copy paste this code before following the display steps
+	if (displayReady) {
+		graphSetPasskey(passkey, shown);
+	}
+#endif
+}
+
 void gecko_evt_le_connection_closed(uint16 reason, uint8 connection) {
+	throughput_ConnectionClosed(connection);
+	gattClient_ConnectionClosed(connection);
+	upgrade_ConnectionClosed(connection);
+	pressCount_ConnectionClosed(connection);
+	eventLog_ConnectionClosed(connection);
+	preparedWrite_ConnectionClosed(connection);
+	hibernate_ConnectionClosed();
+	showPasskey(0, false);
+
+	uint8 record[] = { connection, reason, reason >> 8 };
+	eventLog_Write(EventLogTypeConnectionClosed, record, sizeof(record));
+
 	/* Check if need to boot to dfu mode */
 	if (boot_to_dfu) {
 		/* Enter to DFU OTA mode */
 		gecko_cmd_system_reset(2);
-	} else {
+	} else if (upgrade_InstallPending()) {
+		/* Reboot into the image received in the background */
+		upgrade_Install();
+	} else if (!reconnect_ConnectionClosed(reason, connection)) {
 		/* Restart advertising after client has disconnected */
-		gecko_cmd_le_gap_set_mode(le_gap_general_discoverable, le_gap_undirected_connectable);
+		advertising_Start();
 	}
 }
 
-void gecko_evt_gatt_server_user_write_request(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset, uint8array value) {
-	/* Events related to OTA upgrading
-	 ----------------------------------------------------------------------------- */
+/* User characteristic handlers, dispatched by handle, see gatt_dispatch.h
+ ----------------------------------------------------------------------------- */
+
+/* If ota_control was written, boot the device into Device Firmware Upgrade (DFU) mode.
+ * Only the in-place OTA DFU Gecko bootloader has a DFU mode. Boards with SPI flash
+ * use the SPI flash storage bootloader, and upgrade through the image characteristics. */
+uint8 gattUser_OtaControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+#ifdef FEATURE_SPI_FLASH
+	return (uint8) bg_err_att_request_not_supported;
+#else
+	/* Set flag to enter to OTA mode, the connection is closed once the write is answered */
+	boot_to_dfu = 1;
+	return bg_err_success;
+#endif
+}
+
+uint8 gattUser_StreamWrite(uint8 connection, uint8 len, const uint8 *data) {
+	throughput_StreamWrite(connection, len, data);
+	return bg_err_success;
+}
+
+uint8 gattUser_StreamControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return throughput_ControlWrite(connection, len, data);
+}
+
+uint8 gattUser_ImageDataWrite(uint8 connection, uint8 len, const uint8 *data) {
+	upgrade_DataWrite(connection, len, data);
+	return bg_err_success;
+}
+
+uint8 gattUser_ImageControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return upgrade_ControlWrite(connection, len, data);
+}
+
+void gattUser_TelemetryKeyRead(uint8 connection, uint16 offset) {
+	telemetry_KeyRead(connection, offset);
+}
+
+void gattUser_PressCountRead(uint8 connection, uint16 offset) {
+	pressCount_Read(connection, offset);
+}
 
-	/* Check if the user-type OTA Control Characteristic was written.
-	 * If ota_control was written, boot the device into Device Firmware Upgrade (DFU) mode. */
-	if (characteristic == gattdb_ota_control) {
-		/* Set flag to enter to OTA mode */
-		boot_to_dfu = 1;
-		/* Send response to Write Request */
-		gecko_cmd_gatt_server_send_user_write_response(connection,
-		gattdb_ota_control, bg_err_success);
+uint8 gattUser_PressCountWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return pressCount_ControlWrite(connection, len, data);
+}
 
+uint8 gattUser_EventLogControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return eventLog_ControlWrite(connection, len, data);
+}
+
+void gecko_evt_gatt_server_user_write_request(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset, const uint8array *value) {
+	gattDispatch_Write(connection, characteristic, att_opcode, offset, value);
+	if (boot_to_dfu) {
 		/* Close connection to enter to DFU OTA mode */
 		gecko_cmd_endpoint_close(connection);
 	}
 }
 
+void gecko_evt_gatt_server_user_read_request(uint8 connection, uint16 characteristic, uint8 att_opcode, uint16 offset) {
+	gattDispatch_Read(connection, characteristic, att_opcode, offset);
+}
+
+void gecko_evt_gatt_server_execute_write_completed(uint8 connection, uint16 result) {
+	gattDispatch_ExecuteWrite(connection, result);
+}
+
+void gecko_evt_gatt_server_characteristic_status(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+	throughput_CharacteristicStatus(connection, characteristic, status_flags, client_config_flags);
+	upgrade_CharacteristicStatus(connection, characteristic, status_flags, client_config_flags);
+	pressCount_CharacteristicStatus(connection, characteristic, status_flags, client_config_flags);
+	eventLog_CharacteristicStatus(connection, characteristic, status_flags, client_config_flags);
+}
+
+void throughput_Refill(void) {
+	eventLog_Refill();
+}
+
+void gecko_evt_gatt_mtu_exchanged(uint8 connection, uint16 mtu) {
+	throughput_MtuExchanged(connection, mtu);
+}
+
+void gecko_evt_le_connection_phy_status(uint8 connection, uint8 phy) {
+	throughput_PhyStatus(connection, phy);
+}
+
+void gecko_evt_sm_passkey_display(uint8 connection, uint32 passkey) {
+	LogInfo("Passkey for connection %d: %06lu", connection, passkey);
+	showPasskey(passkey, true);
+}
+
+void gecko_evt_sm_bonded(uint8 connection, uint8 bonding) {
+	showPasskey(0, false);
+	reconnect_Bonded(connection, bonding);
+	gattClient_Bonded(connection, bonding);
+}
+
+void gecko_evt_sm_bonding_failed(uint8 connection, uint16 reason) {
+	LogWarn("Bonding failed for connection %d: 0x%x", connection, reason);
+	showPasskey(0, false);
+}
+
+void gecko_evt_sm_list_bonding_entry(uint8 bonding, bd_addr address, uint8 address_type) {
+	reconnect_ListBondingEntry(bonding, address, address_type);
+}
+
+void gecko_evt_sm_list_all_bondings_complete(void) {
+	reconnect_ListAllBondingsComplete();
+}
+
+void gecko_evt_gatt_service(uint8 connection, uint32 service, const uint8array *uuid) {
+	gattClient_Service(connection, service, uuid);
+}
+
+void gecko_evt_gatt_characteristic(uint8 connection, uint16 characteristic, uint8 properties, const uint8array *uuid) {
+	gattClient_Characteristic(connection, characteristic, uuid);
+}
+
+void gecko_evt_gatt_procedure_completed(uint8 connection, uint16 result) {
+	gattClient_ProcedureCompleted(connection, result);
+}
+
+void gattClient_Ready(uint8 connection, uint16 result, const uint16 *handles, bool cached) {
+	if (result != bg_err_success) {
+		LogInfo("Accessory discovery failed on connection %d: 0x%x", connection, result);
+		return;
+	}
+	LogInfo("Accessory battery level handle %d%s", handles[0], cached ? " (cached)" : "");
+}
+
 /**************************************************************************//**
  * @brief   Register a callback function at the given frequency.
  *
@@ -290,6 +709,13 @@ int rtcIntCallbackRegister(void (*pFunction)(void*),
 {
   #ifndef FEATURE_IOEXPANDER
 
+  #if DISPLAY_POLARITY_LETIMER
+  /* LETIMER0 toggles the pin in EM2, so there is nothing to wake up for */
+  if (displayPolarity_Start(frequency)) {
+    return 0;
+  }
+  #endif /* DISPLAY_POLARITY_LETIMER */
+
   dispPolarityInvert =  pFunction;
   /* Start timer with required frequency */
   gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(1000 / frequency), AppTimerIDDispPolInv, false);
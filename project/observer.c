@@ -0,0 +1,184 @@
+/*****************************************************************************
+ * @file observer.c
+ * @brief Observer mode with duplicate filtering
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "observer.h"
+
+#if OBSERVER_ENABLED
+
+#include <string.h>
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "logging.h"
+
+#if (OBSERVER_CACHE_SIZE & (OBSERVER_CACHE_SIZE - 1)) != 0
+#error OBSERVER_CACHE_SIZE must be a power of 2
+#endif
+
+#define CACHE_MASK (OBSERVER_CACHE_SIZE - 1)
+/* Packet type 4 is a scan response, the rest are advertisements */
+#define PACKET_TYPE_SCAN_RESPONSE 4
+#define AGE_TICK_MS 1000
+
+#define FNV_OFFSET 2166136261UL
+#define FNV_PRIME 16777619UL
+
+typedef struct {
+	bd_addr address;
+	uint8 addressType;
+	/* Slot has held an entry, so probing must continue past it */
+	bool used;
+	/* Heard within OBSERVER_ENTRY_TIMEOUT */
+	bool live;
+	/* Second of the last report, from the age tick counter */
+	uint16 lastSeen;
+	uint32 advHash;
+	uint32 scanResponseHash;
+} CacheEntry;
+
+static CacheEntry cache[OBSERVER_CACHE_SIZE];
+static ObserverStats stats;
+/* Seconds since the observer started, wraps */
+static uint16 now;
+static bool scanning;
+
+static uint32 fnv1a(uint32 hash, const uint8 *data, uint8 len) {
+	for (uint8 i = 0; i < len; i++) {
+		hash = (hash ^ data[i]) * FNV_PRIME;
+	}
+	return hash;
+}
+
+/* Find the entry for an address, or a slot to insert it. Sets *found if it was in the cache. */
+static CacheEntry *lookup(const bd_addr *address, uint8 addressType, bool *found) {
+	uint32 index = fnv1a(FNV_OFFSET, address->addr, sizeof(address->addr)) & CACHE_MASK;
+	CacheEntry *freeSlot = NULL;
+	CacheEntry *oldest = NULL;
+	*found = false;
+	for (int i = 0; i < OBSERVER_MAX_PROBE; i++) {
+		CacheEntry *entry = &cache[(index + i) & CACHE_MASK];
+		if (!entry->used) {
+			/* Nothing has been stored beyond a never used slot */
+			return freeSlot ? freeSlot : entry;
+		}
+		if (entry->addressType == addressType && memcmp(entry->address.addr, address->addr, sizeof(address->addr)) == 0) {
+			*found = entry->live;
+			return entry;
+		}
+		if (!entry->live) {
+			if (!freeSlot) {
+				freeSlot = entry;
+			}
+		} else if (!oldest || (uint16) (now - entry->lastSeen) > (uint16) (now - oldest->lastSeen)) {
+			oldest = entry;
+		}
+	}
+	if (freeSlot) {
+		return freeSlot;
+	}
+	stats.evicted++;
+	return oldest;
+}
+
+void observer_Start(void) {
+	gecko_cmd_le_gap_set_scan_parameters(OBSERVER_SCAN_INTERVAL, OBSERVER_SCAN_WINDOW, 0);
+	uint16 result = gecko_cmd_le_gap_discover(le_gap_discover_observation)->result;
+	if (result != bg_err_success) {
+		LogWarn("Could not start scanning: 0x%x", result);
+		return;
+	}
+	scanning = true;
+	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(AGE_TICK_MS), AppTimerIDObserverAge, false);
+}
+
+void observer_Stop(void) {
+	if (!scanning) {
+		return;
+	}
+	scanning = false;
+	gecko_cmd_le_gap_end_procedure();
+	gecko_cmd_hardware_set_soft_timer(TIMER_STOP, AppTimerIDObserverAge, false);
+	LogInfo("Observer stopped: %lu reports, %lu new, %lu changed, %lu dropped, %lu evicted", stats.reports, stats.new, stats.changed, stats.dropped, stats.evicted);
+}
+
+void observer_GetStats(ObserverStats *s) {
+	*s = stats;
+	s->entries = 0;
+	for (int i = 0; i < OBSERVER_CACHE_SIZE; i++) {
+		if (cache[i].live) {
+			s->entries++;
+		}
+	}
+}
+
+void observer_ResetStats(void) {
+	memset(&stats, 0, sizeof(stats));
+}
+
+void observer_ScanResponse(int8 rssi, uint8 packetType, bd_addr address, uint8 addressType, uint8 len, const uint8 *data) {
+	stats.reports++;
+	uint32 hash = fnv1a(FNV_OFFSET, data, len);
+	bool found;
+	CacheEntry *entry = lookup(&address, addressType, &found);
+	uint32 *entryHash = packetType == PACKET_TYPE_SCAN_RESPONSE ? &entry->scanResponseHash : &entry->advHash;
+	if (!found) {
+		entry->address = address;
+		entry->addressType = addressType;
+		entry->used = true;
+		entry->live = true;
+		entry->advHash = 0;
+		entry->scanResponseHash = 0;
+		stats.new++;
+	} else if (*entryHash == hash) {
+		entry->lastSeen = now;
+		stats.dropped++;
+		return;
+	} else {
+		stats.changed++;
+	}
+	*entryHash = hash;
+	entry->lastSeen = now;
+	if (observer_Report) {
+		observer_Report(address, addressType, rssi, packetType, !found, len, data);
+	}
+}
+
+void observer_AgeTick(void) {
+	now++;
+	for (int i = 0; i < OBSERVER_CACHE_SIZE; i++) {
+		if (cache[i].live && (uint16) (now - cache[i].lastSeen) > OBSERVER_ENTRY_TIMEOUT) {
+			cache[i].live = false;
+		}
+	}
+}
+
+#endif /* OBSERVER_ENABLED */
@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * @file observer.h
+ * @brief Observer mode with duplicate filtering
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef OBSERVER_H_
+#define OBSERVER_H_
+
+#include "bg_types.h"
+
+/* The observer is off unless built with OBSERVER_ENABLED 1, as scanning
+ * keeps the radio receiving and works against the low power modes. When
+ * enabled it is started at boot and scans passively, by default for 10 ms in
+ * every 100 ms, and passes every advertising report
+ * through a fixed size address cache. Each entry holds the advertiser address
+ * and a hash of its last advertising and scan response payloads. Reports that
+ * match the cache are dropped in the event handler, so only new advertisers
+ * and changed payloads reach observer_Report().
+ *
+ * Entries that have not been heard for OBSERVER_ENTRY_TIMEOUT seconds are
+ * aged out, so an advertiser coming back into range is reported as new.
+ * When the cache is full the least recently heard entry in the probe window
+ * is evicted.
+ */
+
+/** Set to 1 to build the observer and start it at boot. */
+#ifndef OBSERVER_ENABLED
+#define OBSERVER_ENABLED 0
+#endif
+
+/** Number of cache entries, 20 bytes of RAM each. Must be a power of 2. */
+#ifndef OBSERVER_CACHE_SIZE
+#define OBSERVER_CACHE_SIZE 64
+#endif
+
+/** Number of slots probed from the hashed slot before evicting. */
+#ifndef OBSERVER_MAX_PROBE
+#define OBSERVER_MAX_PROBE 8
+#endif
+
+/** Seconds without a report before an entry is aged out. */
+#ifndef OBSERVER_ENTRY_TIMEOUT
+#define OBSERVER_ENTRY_TIMEOUT 30
+#endif
+
+/** Scan interval and window in units of 0.625ms. Equal values scan continuously. */
+#ifndef OBSERVER_SCAN_INTERVAL
+#define OBSERVER_SCAN_INTERVAL 160
+#endif
+#ifndef OBSERVER_SCAN_WINDOW
+#define OBSERVER_SCAN_WINDOW 16
+#endif
+
+typedef struct {
+	/** Reports received from the stack */
+	uint32 reports;
+	/** Reports from advertisers not in the cache */
+	uint32 new;
+	/** Reports with a changed payload */
+	uint32 changed;
+	/** Duplicate reports dropped */
+	uint32 dropped;
+	/** Live entries evicted to make room */
+	uint32 evicted;
+	/** Entries currently in the cache */
+	uint16 entries;
+} ObserverStats;
+
+/***************************************************************************//**
+ * @brief
+ *   Start passive scanning.
+ ******************************************************************************/
+void observer_Start(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Stop scanning. The cache is kept.
+ ******************************************************************************/
+void observer_Stop(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Get the filter statistics.
+ *
+ * @param[out] stats
+ *   Filled with the current statistics.
+ ******************************************************************************/
+void observer_GetStats(ObserverStats *stats);
+
+/***************************************************************************//**
+ * @brief
+ *   Reset the filter statistics.
+ ******************************************************************************/
+void observer_ResetStats(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Call from gecko_evt_le_gap_scan_response().
+ ******************************************************************************/
+void observer_ScanResponse(int8 rssi, uint8 packetType, bd_addr address, uint8 addressType, uint8 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   Call when the AppTimerIDObserverAge timer fires.
+ ******************************************************************************/
+void observer_AgeTick(void);
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you should implement to handle filtered reports.
+ *
+ * @param[in] address
+ *   The advertiser address.
+ *
+ * @param[in] addressType
+ *   The advertiser address type.
+ *
+ * @param[in] rssi
+ *   The signal strength of the report.
+ *
+ * @param[in] packetType
+ *   The packet type from the scan response event.
+ *
+ * @param[in] isNew
+ *   True if the advertiser was not in the cache, false if its payload changed.
+ *
+ * @param[in] len
+ *   The payload length.
+ *
+ * @param[in] data
+ *   The payload.
+ ******************************************************************************/
+void observer_Report(bd_addr address, uint8 addressType, int8 rssi, uint8 packetType, bool isNew, uint8 len, const uint8 *data) __attribute__((weak));
+
+#endif /* OBSERVER_H_ */
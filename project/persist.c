@@ -0,0 +1,168 @@
+/*****************************************************************************
+ * @file persist.c
+ * @brief Write coalescing persistent storage over PS keys
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "persist.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "crc.h"
+#include "logging.h"
+
+typedef struct {
+	uint16 key;
+	uint8 *value;
+	uint8 length;
+	uint16 minInterval;
+	bool dirty;
+	/* The flash holds the value with savedCrc */
+	bool stored;
+	uint32 savedCrc;
+	/* Seconds since boot of the last write, if written this boot */
+	bool written;
+	uint32 writeTime;
+} PersistEntry;
+
+static PersistEntry entries[PERSIST_MAX_KEYS];
+static uint8 entryCount;
+static bool flushScheduled;
+
+static uint32 now(void) {
+	return gecko_cmd_hardware_get_time()->seconds;
+}
+
+static PersistEntry *findEntry(uint16 key) {
+	for (uint8 i = 0; i < entryCount; i++) {
+		if (entries[i].key == key) {
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+static void scheduleFlush(uint32 seconds) {
+	gecko_cmd_hardware_set_soft_timer(seconds * TIMER_CLK_FREQ, AppTimerIDPersist, true);
+	flushScheduled = true;
+}
+
+/* Returns false if the save failed */
+static bool save(PersistEntry *e) {
+	uint32 crc = crc_Crc32(0, e->value, e->length);
+	e->dirty = false;
+	if (e->stored && crc == e->savedCrc) {
+		/* Changed back to what is already stored */
+		return true;
+	}
+	uint16 result = gecko_cmd_flash_ps_save(e->key, e->length, e->value)->result;
+	if (result != bg_err_success) {
+		LogWarn("Could not save PS key 0x%04x: 0x%x", e->key, result);
+		e->dirty = true;
+		return false;
+	}
+	e->stored = true;
+	e->savedCrc = crc;
+	e->written = true;
+	e->writeTime = now();
+	return true;
+}
+
+bool persist_Register(uint16 key, void *value, uint8 length, uint16 minInterval) {
+	if (entryCount >= PERSIST_MAX_KEYS || length > PERSIST_MAX_LENGTH || findEntry(key)) {
+		LogWarn("Could not register PS key 0x%04x", key);
+		return false;
+	}
+	PersistEntry *e = &entries[entryCount++];
+	memset(e, 0, sizeof(*e));
+	e->key = key;
+	e->value = value;
+	e->length = length;
+	e->minInterval = minInterval;
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(key);
+	if (rsp->result != bg_err_success || rsp->value.len != length) {
+		return false;
+	}
+	memcpy(value, rsp->value.data, length);
+	e->stored = true;
+	e->savedCrc = crc_Crc32(0, value, length);
+	return true;
+}
+
+void persist_Changed(uint16 key) {
+	PersistEntry *e = findEntry(key);
+	if (!e) {
+		return;
+	}
+	e->dirty = true;
+	if (!flushScheduled) {
+		scheduleFlush(PERSIST_FLUSH_DELAY);
+	}
+}
+
+void persist_Flush(void) {
+	flushScheduled = false;
+	uint32 time = now();
+	/* Seconds until the next value is due, 0 if none is waiting */
+	uint32 wait = 0;
+	uint8 saved = 0;
+	for (uint8 i = 0; i < entryCount; i++) {
+		PersistEntry *e = &entries[i];
+		if (!e->dirty) {
+			continue;
+		}
+		uint32 elapsed = time - e->writeTime;
+		uint32 due = 0;
+		if (e->written && elapsed < e->minInterval) {
+			due = e->minInterval - elapsed;
+		} else if (save(e)) {
+			saved++;
+		} else {
+			due = PERSIST_FLUSH_DELAY;
+		}
+		if (due && (wait == 0 || due < wait)) {
+			wait = due;
+		}
+	}
+	if (saved) {
+		LogInfo("Persisted %d values", saved);
+	}
+	if (wait) {
+		scheduleFlush(wait);
+	}
+}
+
+void persist_Sync(void) {
+	for (uint8 i = 0; i < entryCount; i++) {
+		if (entries[i].dirty) {
+			save(&entries[i]);
+		}
+	}
+}
@@ -0,0 +1,106 @@
+/*****************************************************************************
+ * @file persist.h
+ * @brief Write coalescing persistent storage over PS keys
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef PERSIST_H_
+#define PERSIST_H_
+
+#include "bg_types.h"
+
+/* Values that change often, such as counters, are kept in RAM and written to
+ * their PS keys later instead of on every change. Each registered value is
+ * loaded into its RAM copy when registered. Changing it only marks it dirty,
+ * and PERSIST_FLUSH_DELAY seconds after the first change every dirty value is
+ * written in one pass. A value is written at most once every minInterval
+ * seconds. If it changes again sooner, it waits for a later pass. Values that
+ * end up the same as in the flash are not written at all.
+ *
+ * A PS save can stall for a page erase when the PS store is compacted, so
+ * fewer saves mean fewer stalls as well as less wear.
+ *
+ * persist_Sync() writes everything dirty straight away, e.g. before RAM is lost.
+ */
+
+/** Maximum number of registered values. */
+#ifndef PERSIST_MAX_KEYS
+#define PERSIST_MAX_KEYS 8
+#endif
+
+/** Longest value, the PS key limit. */
+#define PERSIST_MAX_LENGTH 56
+
+/** Seconds from the first change to the write pass. */
+#ifndef PERSIST_FLUSH_DELAY
+#define PERSIST_FLUSH_DELAY 10
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Register a RAM value to be kept in a PS key, and load it.
+ *
+ * @param[in] key
+ *   The PS key.
+ *
+ * @param[in,out] value
+ *   The value, which must stay valid. Receives the stored value, and is left
+ *   alone if there is none.
+ *
+ * @param[in] length
+ *   The value length, at most PERSIST_MAX_LENGTH bytes.
+ *
+ * @param[in] minInterval
+ *   Minimum seconds between writes of this value.
+ *
+ * @return
+ *   True if a stored value was loaded.
+ ******************************************************************************/
+bool persist_Register(uint16 key, void *value, uint8 length, uint16 minInterval);
+
+/***************************************************************************//**
+ * @brief
+ *   Mark a registered value as changed.
+ ******************************************************************************/
+void persist_Changed(uint16 key);
+
+/***************************************************************************//**
+ * @brief
+ *   Write the dirty values that are due. Call when the AppTimerIDPersist timer fires.
+ ******************************************************************************/
+void persist_Flush(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Write every dirty value now, ignoring the rate limits.
+ ******************************************************************************/
+void persist_Sync(void);
+
+#endif /* PERSIST_H_ */
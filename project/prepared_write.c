@@ -0,0 +1,149 @@
+/*****************************************************************************
+ * @file prepared_write.c
+ * @brief Reassembly of prepared writes in a fixed block pool
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "prepared_write.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "logging.h"
+
+#if PREPARED_WRITE_BLOCKS > 32
+#error PREPARED_WRITE_BLOCKS must be at most 32
+#endif
+
+typedef struct {
+	bool inUse;
+	uint8 connection;
+	uint16 characteristic;
+	uint8 firstBlock;
+	uint8 blockCount;
+	/* Highest byte written plus one */
+	uint16 length;
+} Assembly;
+
+static uint8 pool[PREPARED_WRITE_BLOCKS * PREPARED_WRITE_BLOCK_SIZE];
+/* Bit n set while block n is allocated */
+static uint32 allocated;
+static Assembly assemblies[PREPARED_WRITE_MAX_ASSEMBLIES];
+static uint32 exhausted;
+
+/* First fit run of free blocks, or -1 */
+static int allocate(uint8 count) {
+	uint32 mask = (count >= 32) ? 0xFFFFFFFF : ((uint32) 1 << count) - 1;
+	for (int first = 0; first + count <= PREPARED_WRITE_BLOCKS; first++) {
+		if (!(allocated & (mask << first))) {
+			allocated |= mask << first;
+			return first;
+		}
+	}
+	return -1;
+}
+
+static void release(Assembly *a) {
+	uint32 mask = (a->blockCount >= 32) ? 0xFFFFFFFF : ((uint32) 1 << a->blockCount) - 1;
+	allocated &= ~(mask << a->firstBlock);
+	a->inUse = false;
+}
+
+static Assembly *findAssembly(uint8 connection, uint16 characteristic) {
+	for (int i = 0; i < PREPARED_WRITE_MAX_ASSEMBLIES; i++) {
+		Assembly *a = &assemblies[i];
+		if (a->inUse && a->connection == connection && a->characteristic == characteristic) {
+			return a;
+		}
+	}
+	return NULL;
+}
+
+static Assembly *startAssembly(uint8 connection, uint16 characteristic, uint16 maxLength) {
+	Assembly *a = NULL;
+	for (int i = 0; i < PREPARED_WRITE_MAX_ASSEMBLIES && !a; i++) {
+		if (!assemblies[i].inUse) {
+			a = &assemblies[i];
+		}
+	}
+	uint8 count = (maxLength + PREPARED_WRITE_BLOCK_SIZE - 1) / PREPARED_WRITE_BLOCK_SIZE;
+	int first = (a && count <= PREPARED_WRITE_BLOCKS) ? allocate(count) : -1;
+	if (first < 0) {
+		exhausted++;
+		LogWarn("No room to assemble %d bytes for characteristic %d, %lu times", maxLength, characteristic, exhausted);
+		return NULL;
+	}
+	a->inUse = true;
+	a->connection = connection;
+	a->characteristic = characteristic;
+	a->firstBlock = first;
+	a->blockCount = count;
+	a->length = 0;
+	/* The blocks may hold an earlier value, and the fragments may leave gaps */
+	memset(&pool[first * PREPARED_WRITE_BLOCK_SIZE], 0, count * PREPARED_WRITE_BLOCK_SIZE);
+	return a;
+}
+
+uint8 preparedWrite_Queue(uint8 connection, uint16 characteristic, uint16 maxLength, uint16 offset, uint8 len, const uint8 *data) {
+	if (offset > maxLength || len > maxLength - offset) {
+		return (uint8) bg_err_att_invalid_att_length;
+	}
+	Assembly *a = findAssembly(connection, characteristic);
+	if (!a) {
+		a = startAssembly(connection, characteristic, maxLength);
+		if (!a) {
+			return (uint8) bg_err_att_prepare_queue_full;
+		}
+	}
+	memcpy(&pool[a->firstBlock * PREPARED_WRITE_BLOCK_SIZE + offset], data, len);
+	if (offset + len > a->length) {
+		a->length = offset + len;
+	}
+	return bg_err_success;
+}
+
+void preparedWrite_Execute(uint8 connection, bool commit, PreparedWriteDeliver deliver) {
+	for (int i = 0; i < PREPARED_WRITE_MAX_ASSEMBLIES; i++) {
+		Assembly *a = &assemblies[i];
+		if (!a->inUse || a->connection != connection) {
+			continue;
+		}
+		if (commit) {
+			deliver(connection, a->characteristic, a->length, &pool[a->firstBlock * PREPARED_WRITE_BLOCK_SIZE]);
+		}
+		release(a);
+	}
+}
+
+uint32 preparedWrite_Exhausted(void) {
+	return exhausted;
+}
+
+void preparedWrite_ConnectionClosed(uint8 connection) {
+	preparedWrite_Execute(connection, false, NULL);
+}
@@ -0,0 +1,98 @@
+/*****************************************************************************
+ * @file prepared_write.h
+ * @brief Reassembly of prepared writes in a fixed block pool
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef PREPARED_WRITE_H_
+#define PREPARED_WRITE_H_
+
+#include "bg_types.h"
+
+/* Long writes arrive as prepare write requests at increasing offsets,
+ * followed by one execute write. The fragments are stitched per connection
+ * and characteristic into a statically allocated pool of fixed size blocks,
+ * and the whole value is handed over once when the client executes the queue,
+ * or dropped if it cancels.
+ *
+ * A characteristic gets a run of consecutive blocks sized for its declared
+ * value length on its first fragment, so the value is contiguous and write
+ * handlers take it as they take a short write. Bytes no fragment wrote are
+ * zero. When there are no free blocks
+ * or no free assembly the fragment is answered with prepare queue full, so
+ * the client knows the value was not taken, and the exhaustion is logged.
+ */
+
+/** Bytes per pool block. */
+#ifndef PREPARED_WRITE_BLOCK_SIZE
+#define PREPARED_WRITE_BLOCK_SIZE 32
+#endif
+
+/** Blocks in the pool, at most 32. */
+#ifndef PREPARED_WRITE_BLOCKS
+#define PREPARED_WRITE_BLOCKS 16
+#endif
+
+/** Values being assembled at once, over all connections. */
+#ifndef PREPARED_WRITE_MAX_ASSEMBLIES
+#define PREPARED_WRITE_MAX_ASSEMBLIES 4
+#endif
+
+/** Receives each assembled value when a queue is executed. */
+typedef void (*PreparedWriteDeliver)(uint8 connection, uint16 characteristic, uint16 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   Queue a prepared write fragment.
+ *
+ * @param[in] maxLength
+ *   The declared value length of the characteristic.
+ *
+ * @return
+ *   The ATT result to answer the prepare write request with.
+ ******************************************************************************/
+uint8 preparedWrite_Queue(uint8 connection, uint16 characteristic, uint16 maxLength, uint16 offset, uint8 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   Deliver the values queued on a connection if commit is true, then free them.
+ ******************************************************************************/
+void preparedWrite_Execute(uint8 connection, bool commit, PreparedWriteDeliver deliver);
+
+/***************************************************************************//**
+ * @brief
+ *   Times the pool or assemblies ran out since boot.
+ ******************************************************************************/
+uint32 preparedWrite_Exhausted(void);
+
+/* Event hooks, called from the corresponding gecko events */
+void preparedWrite_ConnectionClosed(uint8 connection);
+
+#endif /* PREPARED_WRITE_H_ */
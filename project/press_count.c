@@ -0,0 +1,241 @@
+/*****************************************************************************
+ * @file press_count.c
+ * @brief Button press counting in EM2 with PRS and PCNT
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "press_count.h"
+#include "util.h"
+#include "em_device.h"
+#include "em_cmu.h"
+#include "em_core.h"
+#include "em_pcnt.h"
+#include "em_prs.h"
+#include "native_gecko.h"
+#include "gatt_db.h"
+#include "InitDevice.h"
+#include "gpio_interrupt.h"
+#include "persist.h"
+#include "value_cache.h"
+#include "logging.h"
+
+#if PRESS_COUNT_THRESHOLD < 1 || PRESS_COUNT_THRESHOLD > 65536
+#error PRESS_COUNT_THRESHOLD must be between 1 and 65536
+#endif
+
+#define NUMBER_OF_BUTTONS 4
+
+static const GPIO_Port_TypeDef ports[NUMBER_OF_BUTTONS] = { BUTTON_LED0_PORT, BUTTON_LED1_PORT, BUTTON_LED2_PORT, BUTTON_LED3_PORT };
+static const unsigned int pins[NUMBER_OF_BUTTONS] = { BUTTON_LED0_PIN, BUTTON_LED1_PIN, BUTTON_LED2_PIN, BUTTON_LED3_PIN };
+
+static bool enabled;
+/* Presses counted before the current counting run */
+static uint32 base;
+/* Counter wraps in the current run, each one PRESS_COUNT_THRESHOLD presses */
+static volatile uint32 overflows;
+/* Total last handed to persist */
+static uint32 saved;
+static uint8 notifyConnection = NO_CONNECTION;
+
+/* Route each selected button to its own PRS channel and AND them onto the first */
+static void routeButtons(bool route) {
+	unsigned int channel = PRESS_COUNT_PRS_CHANNEL;
+	for (int i = 0; i < NUMBER_OF_BUTTONS; i++) {
+		if (!(PRESS_COUNT_BUTTONS & (1 << i))) {
+			continue;
+		}
+		int interrupt = gpio_IntNumber(ports[i], pins[i]);
+		if (interrupt < 0) {
+			LogWarn("Button %d has no interrupt to route", i);
+			continue;
+		}
+		if (route) {
+			/* GPIO PRS signal n follows the pin routed to interrupt n, with the interrupt itself disabled */
+			gpio_IntSetEnabled(ports[i], pins[i], false);
+			PRS_SourceAsyncSignalSet(channel, interrupt < 8 ? PRS_CH_CTRL_SOURCESEL_GPIOL : PRS_CH_CTRL_SOURCESEL_GPIOH,
+					(uint32)(interrupt & 0x07) << _PRS_CH_CTRL_SIGSEL_SHIFT);
+			if (channel > PRESS_COUNT_PRS_CHANNEL) {
+				PRS->CH[channel - 1].CTRL |= PRS_CH_CTRL_ANDNEXT;
+			}
+		} else {
+			PRS->CH[channel].CTRL = 0;
+			gpio_IntSetEnabled(ports[i], pins[i], true);
+		}
+		channel++;
+	}
+}
+
+void PCNT0_IRQHandler(void) {
+	uint32 flags = PCNT_IntGet(PCNT0);
+	PCNT_IntClear(PCNT0, flags);
+	if (flags & PCNT_IF_OF) {
+		overflows++;
+		gecko_external_signal(PRESS_COUNT_SIGNAL);
+	}
+}
+
+/* Serve reads of the total from the value cache while it only changes on events */
+static void publish(uint32 total) {
+	uint8 value[4];
+	putUint32(value, total);
+	valueCache_Publish(gattdb_press_count, value, sizeof(value));
+}
+
+static void save(uint32 total) {
+	saved = total;
+	persist_Changed(PRESS_COUNT_PS_KEY);
+}
+
+void pressCount_Init(void) {
+	valueCache_Register(gattdb_press_count, NULL);
+	if (persist_Register(PRESS_COUNT_PS_KEY, &saved, sizeof(saved), PRESS_COUNT_SAVE_INTERVAL)) {
+		pressCount_Restore(saved);
+	} else {
+		publish(base);
+	}
+}
+
+uint32 pressCount_Total(void) {
+	if (!enabled) {
+		return base;
+	}
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_CRITICAL();
+	uint32 count = PCNT_CounterGet(PCNT0);
+	uint32 wraps = overflows;
+	if (PCNT_IntGet(PCNT0) & PCNT_IF_OF) {
+		/* Wrapped but not handled yet, so the count read may be from before the wrap */
+		count = PCNT_CounterGet(PCNT0);
+		wraps++;
+	}
+	CORE_EXIT_CRITICAL();
+	return base + wraps * PRESS_COUNT_THRESHOLD + count;
+}
+
+void pressCount_Restore(uint32 total) {
+	if (!enabled) {
+		base = total;
+		publish(base);
+	}
+}
+
+bool pressCount_Enabled(void) {
+	return enabled;
+}
+
+void pressCount_SetEnabled(bool enable) {
+	if (enable == enabled) {
+		return;
+	}
+	if (enable) {
+		if (pressCount_WillStart) {
+			pressCount_WillStart();
+		}
+		CMU_ClockEnable(cmuClock_PRS, true);
+		CMU_ClockEnable(cmuClock_PCNT0, true);
+		routeButtons(true);
+
+		PCNT_Init_TypeDef init = PCNT_INIT_DEFAULT;
+		/* Count from LFACLK so counting carries on in EM2 */
+		init.mode = pcntModeOvsSingle;
+		init.top = PRESS_COUNT_THRESHOLD - 1;
+		/* The buttons pull the pin low when pressed */
+		init.negEdge = true;
+		init.filter = true;
+		init.s0PRS = (PCNT_PRSSel_TypeDef) PRESS_COUNT_PRS_CHANNEL;
+		PCNT_Init(PCNT0, &init);
+		PCNT_PRSInputEnable(PCNT0, pcntPRSInputS0, true);
+
+		overflows = 0;
+		PCNT_IntClear(PCNT0, PCNT_IF_OF);
+		PCNT_IntEnable(PCNT0, PCNT_IF_OF);
+		NVIC_ClearPendingIRQ(PCNT0_IRQn);
+		NVIC_EnableIRQ(PCNT0_IRQn);
+		enabled = true;
+		/* The counter moves without waking the CPU, so reads go to pressCount_Read() */
+		valueCache_Invalidate(gattdb_press_count);
+		LogInfo("Press counting started");
+	} else {
+		base = pressCount_Total();
+		enabled = false;
+		NVIC_DisableIRQ(PCNT0_IRQn);
+		PCNT_Reset(PCNT0);
+		CMU_ClockEnable(cmuClock_PCNT0, false);
+		routeButtons(false);
+		save(base);
+		publish(base);
+		LogInfo("Press counting stopped at %lu", base);
+	}
+}
+
+void pressCount_Signal(void) {
+	uint32 total = pressCount_Total();
+	LogInfo("%lu presses", total);
+	save(total);
+	if (notifyConnection != NO_CONNECTION) {
+		uint8 value[4];
+		putUint32(value, total);
+		gecko_cmd_gatt_server_send_characteristic_notification(notifyConnection, gattdb_press_count, sizeof(value), value);
+	}
+}
+
+void pressCount_Read(uint8 connection, uint16 offset) {
+	uint8 value[4];
+	putUint32(value, pressCount_Total());
+	if (offset > sizeof(value)) {
+		gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_press_count, (uint8) bg_err_att_invalid_offset, 0, NULL);
+		return;
+	}
+	gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_press_count, bg_err_success, sizeof(value) - offset, &value[offset]);
+}
+
+uint8 pressCount_ControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	if (len != 1) {
+		return (uint8) bg_err_att_invalid_att_length;
+	}
+	if (data[0] > 1) {
+		return (uint8) bg_err_att_request_not_supported;
+	}
+	pressCount_SetEnabled(data[0]);
+	return bg_err_success;
+}
+
+void pressCount_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+	if (characteristic != gattdb_press_count || status_flags != gatt_server_client_config) {
+		return;
+	}
+	notifyConnection = (client_config_flags & gatt_notification) ? connection : NO_CONNECTION;
+}
+
+void pressCount_ConnectionClosed(uint8 connection) {
+	if (connection == notifyConnection) {
+		notifyConnection = NO_CONNECTION;
+	}
+}
@@ -0,0 +1,140 @@
+/*****************************************************************************
+ * @file press_count.h
+ * @brief Button press counting in EM2 with PRS and PCNT
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef PRESS_COUNT_H_
+#define PRESS_COUNT_H_
+
+#include "bg_types.h"
+
+/* In counting mode the selected buttons are not handled by GPIO interrupts.
+ * Instead their pins are routed over PRS to PCNT0, which counts presses from
+ * LFACLK in EM2 without waking the CPU. The CPU only wakes when
+ * PRESS_COUNT_THRESHOLD presses have been counted, or when a client reads the
+ * press count characteristic.
+ *
+ * EFR32BG1 has a single PCNT, so the selected buttons share one counter: each
+ * button has its own PRS channel and the channels are ANDed together (the
+ * buttons are active low), so presses that overlap count once.
+ *
+ * Press count characteristic:
+ *   read   - <uint32 total presses> little endian. Served from the value cache
+ *            while not counting, and read from the counter while counting.
+ *   write  - 0x01 to start counting mode, 0x00 to stop it
+ *   notify - the total, every PRESS_COUNT_THRESHOLD presses
+ *
+ * The total is kept across resets in a PS key when it is notified and when
+ * counting stops, written at most every PRESS_COUNT_SAVE_INTERVAL seconds
+ * (see persist.h). Presses since the last threshold are lost on a reset.
+ */
+
+/** Buttons to count, bit n for BUTTON_LEDn. */
+#ifndef PRESS_COUNT_BUTTONS
+#define PRESS_COUNT_BUTTONS 0x0F
+#endif
+
+/** Presses between wake ups. At most 65536. */
+#ifndef PRESS_COUNT_THRESHOLD
+#define PRESS_COUNT_THRESHOLD 100
+#endif
+
+/** First PRS channel used. One channel per selected button, consecutively. */
+#ifndef PRESS_COUNT_PRS_CHANNEL
+#define PRESS_COUNT_PRS_CHANNEL 0
+#endif
+
+/** PS key holding the total. */
+#ifndef PRESS_COUNT_PS_KEY
+#define PRESS_COUNT_PS_KEY 0x4051
+#endif
+
+/** Minimum seconds between writes of the total. */
+#ifndef PRESS_COUNT_SAVE_INTERVAL
+#define PRESS_COUNT_SAVE_INTERVAL 60
+#endif
+
+/** External signal raised when the threshold is reached. Must not overlap the GPIO signals. */
+#define PRESS_COUNT_SIGNAL 0x00010000
+
+/***************************************************************************//**
+ * @brief
+ *   Load the total kept from before the last reset. Call from gecko_evt_system_boot().
+ ******************************************************************************/
+void pressCount_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Start or stop counting mode.
+ *
+ * @note
+ *   The selected buttons must already be configured as inputs with
+ *   gpio_IntConfig(). Their interrupts are disabled while counting and
+ *   re-enabled when counting stops.
+ *
+ * @param[in] enabled
+ *   True to start counting.
+ ******************************************************************************/
+void pressCount_SetEnabled(bool enabled);
+
+/***************************************************************************//**
+ * @brief
+ *   Whether counting mode is on.
+ ******************************************************************************/
+bool pressCount_Enabled(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Presses counted, including those still in the counter.
+ ******************************************************************************/
+uint32 pressCount_Total(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Carry on from a total saved before a reset. Only valid while not counting.
+ ******************************************************************************/
+void pressCount_Restore(uint32 total);
+
+/* Event hooks, called from the corresponding gecko events */
+void pressCount_Signal(void);
+void pressCount_Read(uint8 connection, uint16 offset);
+uint8 pressCount_ControlWrite(uint8 connection, uint8 len, const uint8 *data);
+void pressCount_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags);
+void pressCount_ConnectionClosed(uint8 connection);
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you can implement to be told when counting mode is
+ *   about to start, so buttons driven as outputs can be made inputs.
+ ******************************************************************************/
+void pressCount_WillStart(void) __attribute__((weak));
+
+#endif /* PRESS_COUNT_H_ */
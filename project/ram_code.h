@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * @file ram_code.h
+ * @brief Placement of hot code and tables in RAM
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef RAM_CODE_H_
+#define RAM_CODE_H_
+
+/* Functions marked RAM_CODE and tables marked RAM_TABLE are copied from flash
+ * to RAM by the startup code along with the initialised data, so the interrupt
+ * and event dispatch paths run without flash wait states. The linker scripts
+ * collect them between __ram_code_start__ and __ram_code_end__ (GCC) or in
+ * block RAM_CODE (IAR).
+ *
+ * Every byte here is taken from the RAM left for the application, so keep it
+ * to the few functions run on every interrupt or event. Switch tables the
+ * compiler generates are placed with their function, const tables they read
+ * need RAM_TABLE. Functions called from a RAM function still run from flash.
+ *
+ * tools/ram_report.py lists what was placed and its size after a build.
+ */
+
+#if defined(__GNUC__)
+/* long_call, as RAM is out of branch range of flash */
+#define RAM_CODE __attribute__((section(".ram_code"), noinline, long_call))
+#define RAM_TABLE(F) F __attribute__((section(".ram_table")))
+#elif defined(__ICCARM__)
+#define RAM_CODE __ramfunc
+#define RAM_TABLE(F) _Pragma("location=\".ram_table\"") F
+#else
+#define RAM_CODE
+#define RAM_TABLE(F) F
+#endif
+
+#endif /* RAM_CODE_H_ */
@@ -0,0 +1,195 @@
+/*****************************************************************************
+ * @file ram_monitor.c
+ * @brief Stack and RAM headroom monitoring
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "ram_monitor.h"
+#include "util.h"
+#include <string.h>
+#include "em_device.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "gatt_db.h"
+#include "app_timer.h"
+#include "value_cache.h"
+#include "logging.h"
+
+#define PAINT 0xC5C5C5C5
+#define PAINT_BYTE 0xC5
+#define GUARD_REGION 7
+#define OVERFLOW_MAGIC 0x53544B4F
+#define STATUS_LENGTH 13
+
+#if defined(__ICCARM__)
+#pragma section = "CSTACK"
+#define STACK_LIMIT ((uint32)__section_begin("CSTACK"))
+#define STACK_TOP ((uint32)__section_end("CSTACK"))
+#else
+extern char __StackLimit[], __StackTop[], __data_start__[], __bss_end__[], __HeapLimit[];
+#define STACK_LIMIT ((uint32)__StackLimit)
+#define STACK_TOP ((uint32)__StackTop)
+#endif
+
+static const uint8 *heapStart;
+static uint32 heapLength;
+/* Lowest stack word that can be used, above the guard */
+static uint32 *stackBottom;
+static uint32 peak;
+static uint32 loggedPeak;
+static uint32 lastSample;
+static bool overflowed;
+
+static uint8 statusValue(uint8 *value) {
+	RamStatus status;
+	ramMonitor_Get(&status);
+	putUint16(&value[0], status.stackSize);
+	putUint16(&value[2], status.stackPeak);
+	putUint16(&value[4], status.heapSize);
+	putUint16(&value[6], status.heapPeak);
+	putUint16(&value[8], status.staticSize);
+	putUint16(&value[10], status.unused);
+	value[12] = status.overflowed ? 0x01 : 0x00;
+	return STATUS_LENGTH;
+}
+
+#if RAM_MONITOR_GUARD
+#if RAM_MONITOR_GUARD_SIZE < 32 || (RAM_MONITOR_GUARD_SIZE & (RAM_MONITOR_GUARD_SIZE - 1))
+#error RAM_MONITOR_GUARD_SIZE must be a power of two of at least 32
+#endif
+
+/* The guard is the only MPU region, so the stack has overflowed. This runs on
+ * the overflowed stack, so drop the guard before anything else is pushed, note
+ * the overflow and reset. */
+void MemManage_Handler(void) {
+	MPU->CTRL = 0;
+	RTCC->RET[RAM_MONITOR_RETAINED_REGISTER].REG = OVERFLOW_MAGIC;
+	NVIC_SystemReset();
+}
+
+static void guard(void) {
+	/* A region is aligned to its size */
+	uint32 base = (STACK_LIMIT + RAM_MONITOR_GUARD_SIZE - 1) & ~(uint32)(RAM_MONITOR_GUARD_SIZE - 1);
+	if (base + RAM_MONITOR_GUARD_SIZE >= (uint32) __get_MSP()) {
+		LogWarn("Stack too small for a %d byte guard", RAM_MONITOR_GUARD_SIZE);
+		return;
+	}
+	MPU->RNR = GUARD_REGION;
+	MPU->RBAR = base;
+	/* No access (AP 0), never executed, 2^(SIZE + 1) bytes */
+	MPU->RASR = MPU_RASR_XN_Msk | ((30 - __CLZ(RAM_MONITOR_GUARD_SIZE)) << MPU_RASR_SIZE_Pos) | MPU_RASR_ENABLE_Msk;
+	/* Everything else keeps the default memory map */
+	MPU->CTRL = MPU_CTRL_PRIVDEFENA_Msk | MPU_CTRL_ENABLE_Msk;
+	SCB->SHCSR |= SCB_SHCSR_MEMFAULTENA_Msk;
+	__DSB();
+	__ISB();
+	stackBottom = (uint32 *)(base + RAM_MONITOR_GUARD_SIZE);
+}
+#endif
+
+void ramMonitor_Init(void *heap, uint32 heapSize) {
+	if (RTCC->RET[RAM_MONITOR_RETAINED_REGISTER].REG == OVERFLOW_MAGIC) {
+		RTCC->RET[RAM_MONITOR_RETAINED_REGISTER].REG = 0;
+		overflowed = true;
+		LogWarn("Stack overflowed before the last reset");
+	}
+	stackBottom = (uint32 *) STACK_LIMIT;
+#if RAM_MONITOR_GUARD
+	guard();
+#endif
+	/* Nothing below this frame has been used yet */
+	uint32 *sp = (uint32 *) __get_MSP();
+	for (uint32 *p = stackBottom; p < sp; p++) {
+		*p = PAINT;
+	}
+	peak = STACK_TOP - (uint32) sp;
+	loggedPeak = peak;
+
+	heapStart = heap;
+	heapLength = heapSize;
+	memset(heap, PAINT_BYTE, heapSize);
+
+	valueCache_Register(gattdb_ram_status, statusValue);
+}
+
+static void sample(void) {
+	/* Only words below the last peak can have changed */
+	uint32 *p = stackBottom;
+	uint32 *end = (uint32 *)(STACK_TOP - peak);
+	while (p < end && *p == PAINT) {
+		p++;
+	}
+	if (p == end) {
+		return;
+	}
+	peak = STACK_TOP - (uint32) p;
+	if (peak >= loggedPeak + RAM_MONITOR_LOG_STEP) {
+		loggedPeak = peak;
+		LogInfo("Stack peak %lu of %lu bytes", peak, STACK_TOP - (uint32) stackBottom);
+	}
+}
+
+void ramMonitor_Sample(void) {
+	uint32 now = appTimerNow();
+	if (now - lastSample < TIMER_MS_2_TIMERTICK(RAM_MONITOR_SAMPLE_INTERVAL)) {
+		return;
+	}
+	lastSample = now;
+	sample();
+	/* Read out again at most once per sample */
+	valueCache_Invalidate(gattdb_ram_status);
+}
+
+void ramMonitor_Get(RamStatus *status) {
+	sample();
+	status->stackSize = STACK_TOP - (uint32) stackBottom;
+	status->stackPeak = peak;
+	uint32 used = heapLength;
+	while (used > 0 && heapStart[used - 1] == PAINT_BYTE) {
+		used--;
+	}
+	status->heapSize = heapLength;
+	status->heapPeak = used;
+#if defined(__ICCARM__)
+	status->staticSize = 0;
+	status->unused = 0;
+#else
+	status->staticSize = __bss_end__ - __data_start__;
+	status->unused = __StackLimit - __HeapLimit;
+#endif
+	status->overflowed = overflowed;
+}
+
+void ramMonitor_Report(void) {
+	RamStatus status;
+	ramMonitor_Get(&status);
+	LogInfo("Stack %lu of %lu, heap %lu of %lu, static %lu, unused %lu bytes", status.stackPeak, status.stackSize, status.heapPeak,
+			status.heapSize, status.staticSize, status.unused);
+}
@@ -0,0 +1,148 @@
+/*****************************************************************************
+ * @file ram_monitor.h
+ * @brief Stack and RAM headroom monitoring
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef RAM_MONITOR_H_
+#define RAM_MONITOR_H_
+
+#include "bg_types.h"
+
+/* The main stack and the Bluetooth stack heap are painted with a pattern
+ * before they are used. The deepest point the stack has reached is sampled
+ * from the idle loop at most every RAM_MONITOR_SAMPLE_INTERVAL ms, by scanning
+ * up from the stack limit to the first word no longer painted. Sampling never
+ * sees the stack as deeper than it has been, so a peak near the limit is real.
+ *
+ * The heap peak is the highest byte no longer painted. The Bluetooth stack
+ * allocates from the start of its heap, but if it clears the whole heap at
+ * init the peak shows as the full heap, so only ever read it as an upper bound.
+ *
+ * Static RAM is the initialised data, RAM code (see ram_code.h) and zeroed
+ * data, including the Bluetooth stack heap. Unused RAM is between the end of
+ * the C heap and the stack limit, which is what the stack could grow into if
+ * its reservation were larger, or what trimming it gives back.
+ *
+ * RAM_MONITOR_GUARD is a debugging aid, not an overflow check to rely on in
+ * production; the stack peak is what shows how close the stack came to its
+ * limit. The MPU makes the lowest RAM_MONITOR_GUARD_SIZE bytes of the stack a
+ * no access region, taken from the usable stack, so an overflow faults instead
+ * of silently corrupting the data below it. It costs no time while running.
+ * The fault handler resets the device and the overflow is reported on the
+ * next boot. It can't catch:
+ *   - a frame larger than the guard, whose accesses can land below it without
+ *     touching it. The largest frames are the event log page (over 256 bytes)
+ *     and the delta copy buffer.
+ *   - an overflow that leaves the stack pointer inside the guard, e.g. a push.
+ *     The exception entry then faults too saving registers for the handler,
+ *     which escalates to HardFault, and the overflow is not reported.
+ * Increase the stack reservation by the guard size when enabling it.
+ *
+ * RAM status characteristic, all little endian:
+ *   read - <uint16 stack size> <uint16 stack peak>
+ *          <uint16 heap size> <uint16 heap peak>
+ *          <uint16 static RAM> <uint16 unused RAM>
+ *          <uint8 flags, bit 0 if the stack overflowed before the last reset>
+ * The value is cached (see value_cache.h) and rebuilt at most once per sample.
+ *
+ * Stack and RAM sizes come from the GCC linker symbols. IAR builds report the
+ * CSTACK block as the stack and no static or unused RAM.
+ */
+
+/** Guard the stack limit with the MPU, for debugging. */
+#ifndef RAM_MONITOR_GUARD
+#define RAM_MONITOR_GUARD 0
+#endif
+
+/** Size of the guard in bytes, a power of two of at least 32. Larger than the largest stack frame. */
+#ifndef RAM_MONITOR_GUARD_SIZE
+#define RAM_MONITOR_GUARD_SIZE 512
+#endif
+
+/** Minimum ms between stack samples. */
+#ifndef RAM_MONITOR_SAMPLE_INTERVAL
+#define RAM_MONITOR_SAMPLE_INTERVAL 1000
+#endif
+
+/** Growth of the stack peak in bytes that is logged. */
+#ifndef RAM_MONITOR_LOG_STEP
+#define RAM_MONITOR_LOG_STEP 64
+#endif
+
+/** RTCC retention register noting an overflow across the reset. Registers 0-3 are used by hibernate.c. */
+#ifndef RAM_MONITOR_RETAINED_REGISTER
+#define RAM_MONITOR_RETAINED_REGISTER 31
+#endif
+
+typedef struct {
+	uint32 stackSize;
+	uint32 stackPeak;
+	uint32 heapSize;
+	uint32 heapPeak;
+	uint32 staticSize;
+	uint32 unused;
+	/* The stack overflowed before the last reset */
+	bool overflowed;
+} RamStatus;
+
+/***************************************************************************//**
+ * @brief
+ *   Paint the stack below the caller and the heap, and guard the stack limit.
+ *   Call from main() before gecko_init() and after the RTCC is clocked.
+ *
+ * @param[in] heap
+ *   The Bluetooth stack heap.
+ *
+ * @param[in] heapSize
+ *   Its size in bytes.
+ ******************************************************************************/
+void ramMonitor_Init(void *heap, uint32 heapSize);
+
+/***************************************************************************//**
+ * @brief
+ *   Sample the stack peak, if RAM_MONITOR_SAMPLE_INTERVAL has passed. Call
+ *   from the idle loop.
+ ******************************************************************************/
+void ramMonitor_Sample(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Sample now and get the sizes and peaks.
+ ******************************************************************************/
+void ramMonitor_Get(RamStatus *status);
+
+/***************************************************************************//**
+ * @brief
+ *   Log the sizes and peaks.
+ ******************************************************************************/
+void ramMonitor_Report(void);
+
+#endif /* RAM_MONITOR_H_ */
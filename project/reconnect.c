@@ -0,0 +1,166 @@
+/*****************************************************************************
+ * @file reconnect.c
+ * @brief Fast reconnection of bonded peers
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "reconnect.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "advertising.h"
+#include "broadcast.h"
+#include "logging.h"
+
+#define NO_BONDING 0xFF
+/* Bonding requires MITM protection */
+#define SM_CONFIGURE_MITM 0x01
+
+typedef struct {
+	bd_addr address;
+	uint8 addressType;
+	uint8 bonding;
+} Peer;
+
+static uint8 bondings[RECONNECT_MAX_BONDINGS];
+static uint8 bondingCount;
+static bool listComplete;
+/* Peer of each open connection */
+static Peer connectionPeers[RECONNECT_MAX_CONNECTIONS];
+static bool reconnecting;
+
+static bool findBonding(uint8 bonding) {
+	for (uint8 i = 0; i < bondingCount; i++) {
+		if (bondings[i] == bonding) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void addBonding(uint8 bonding) {
+	if (findBonding(bonding)) {
+		return;
+	}
+	if (bondingCount == RECONNECT_MAX_BONDINGS) {
+		LogWarn("Bonding cache full");
+		return;
+	}
+	bondings[bondingCount++] = bonding;
+}
+
+static void stopReconnecting(void) {
+	if (!reconnecting) {
+		return;
+	}
+	reconnecting = false;
+	gecko_cmd_hardware_set_soft_timer(TIMER_STOP, AppTimerIDReconnect, true);
+	broadcast_SetTargetAddress(NULL, 0);
+}
+
+void reconnect_Init(void) {
+	/* Authenticated bonding, so there are peers to reconnect to, once allowed */
+	gecko_cmd_sm_configure(SM_CONFIGURE_MITM, RECONNECT_IO_CAPABILITY);
+	gecko_cmd_sm_set_bondable_mode(0);
+	for (uint8 i = 0; i < RECONNECT_MAX_CONNECTIONS; i++) {
+		connectionPeers[i].bonding = NO_BONDING;
+	}
+	bondingCount = 0;
+	listComplete = false;
+	gecko_cmd_sm_list_all_bonding();
+}
+
+void reconnect_AllowBonding(void) {
+	LogInfo("Accepting new bonds for %d ms", RECONNECT_PAIRING_WINDOW);
+	gecko_cmd_sm_set_bondable_mode(1);
+	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(RECONNECT_PAIRING_WINDOW), AppTimerIDPairing, true);
+}
+
+void reconnect_PairingTimeout(void) {
+	gecko_cmd_sm_set_bondable_mode(0);
+}
+
+void reconnect_ListBondingEntry(uint8 bonding, bd_addr address, uint8 addressType) {
+	addBonding(bonding);
+}
+
+void reconnect_ListAllBondingsComplete(void) {
+	listComplete = true;
+	LogInfo("%d bondings cached", bondingCount);
+}
+
+void reconnect_ConnectionOpened(bd_addr address, uint8 addressType, uint8 connection, uint8 bonding) {
+	stopReconnecting();
+	if (connection == 0 || connection > RECONNECT_MAX_CONNECTIONS) {
+		return;
+	}
+	Peer *peer = &connectionPeers[connection - 1];
+	peer->address = address;
+	peer->addressType = addressType;
+	peer->bonding = bonding;
+}
+
+void reconnect_Bonded(uint8 connection, uint8 bonding) {
+	if (connection == 0 || connection > RECONNECT_MAX_CONNECTIONS) {
+		return;
+	}
+	Peer *peer = &connectionPeers[connection - 1];
+	peer->bonding = bonding;
+	addBonding(bonding);
+}
+
+bool reconnect_ConnectionClosed(uint16 reason, uint8 connection) {
+	if (connection == 0 || connection > RECONNECT_MAX_CONNECTIONS) {
+		return false;
+	}
+	Peer *peer = &connectionPeers[connection - 1];
+	bool bonded = peer->bonding != NO_BONDING && (!listComplete || findBonding(peer->bonding));
+	if (!bonded || reason == bg_err_bt_remote_user_terminated || reason == bg_err_bt_connection_terminated_by_local_host) {
+		peer->bonding = NO_BONDING;
+		return false;
+	}
+	LogInfo("Bonding %d lost (0x%x), reconnecting", peer->bonding, reason);
+	peer->bonding = NO_BONDING;
+	/* Directed advertising is reserved in this stack version, so use the
+	 * shortest undirected interval and name the peer as the target */
+	broadcast_SetTargetAddress(&peer->address, peer->addressType);
+	advertising_StartHighDuty();
+	reconnecting = true;
+	gecko_cmd_hardware_set_soft_timer(TIMER_MS_2_TIMERTICK(RECONNECT_DURATION), AppTimerIDReconnect, true);
+	return true;
+}
+
+void reconnect_Timeout(void) {
+	if (!reconnecting) {
+		return;
+	}
+	LogInfo("Reconnection timed out");
+	stopReconnecting();
+	advertising_Start();
+}
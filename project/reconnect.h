@@ -0,0 +1,122 @@
+/*****************************************************************************
+ * @file reconnect.h
+ * @brief Fast reconnection of bonded peers
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef RECONNECT_H_
+#define RECONNECT_H_
+
+#include "bg_types.h"
+
+/* The bonding table is listed once at boot and kept in RAM, and updated as
+ * new bonds are made, so deciding whether a peer is known needs no stack
+ * commands.
+ *
+ * New bonds are only accepted for RECONNECT_PAIRING_WINDOW ms after
+ * reconnect_AllowBonding(), which the application calls on a user action.
+ * Bonded peers reconnect and re-encrypt at any time.
+ *
+ * Bonding needs MITM protection: with the default display only IO
+ * capability the peer enters the passkey shown on the display, from
+ * gecko_evt_sm_passkey_display().
+ *
+ * When a bonded peer drops the link unexpectedly (anything other than either
+ * side closing it) the device advertises at the shortest interval with the
+ * peer's address as a target address for RECONNECT_DURATION ms, then falls
+ * back to the normal advertising schedule.
+ */
+
+/** Number of bondings cached in RAM. */
+#ifndef RECONNECT_MAX_BONDINGS
+#define RECONNECT_MAX_BONDINGS 8
+#endif
+
+/** How long to try reconnecting to the last peer in ms. */
+#ifndef RECONNECT_DURATION
+#define RECONNECT_DURATION 1280
+#endif
+
+/** How long new bonds are accepted for in ms. */
+#ifndef RECONNECT_PAIRING_WINDOW
+#define RECONNECT_PAIRING_WINDOW 30000
+#endif
+
+/** Security manager IO capability, display only by default. Must allow MITM protection. */
+#ifndef RECONNECT_IO_CAPABILITY
+#define RECONNECT_IO_CAPABILITY sm_io_capability_displayonly
+#endif
+
+/** Maximum connection handle. */
+#ifndef RECONNECT_MAX_CONNECTIONS
+#define RECONNECT_MAX_CONNECTIONS 4
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Enable bonding and list the bonding table into RAM. Call on boot.
+ ******************************************************************************/
+void reconnect_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Accept new bonds for RECONNECT_PAIRING_WINDOW ms. Call on a user action.
+ ******************************************************************************/
+void reconnect_AllowBonding(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Handle a closed connection.
+ *
+ * @return
+ *   True if reconnection advertising was started, false if the caller should
+ *   start advertising as normal.
+ ******************************************************************************/
+bool reconnect_ConnectionClosed(uint16 reason, uint8 connection);
+
+/* Event hooks, call from the matching gecko events */
+void reconnect_ConnectionOpened(bd_addr address, uint8 addressType, uint8 connection, uint8 bonding);
+void reconnect_Bonded(uint8 connection, uint8 bonding);
+void reconnect_ListBondingEntry(uint8 bonding, bd_addr address, uint8 addressType);
+void reconnect_ListAllBondingsComplete(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Call when the AppTimerIDReconnect timer fires.
+ ******************************************************************************/
+void reconnect_Timeout(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Call when the AppTimerIDPairing timer fires.
+ ******************************************************************************/
+void reconnect_PairingTimeout(void);
+
+#endif /* RECONNECT_H_ */
@@ -0,0 +1,153 @@
+/*****************************************************************************
+ * @file spi_flash.c
+ * @brief Shared access to the MX25 SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "board_features.h"
+
+#ifdef FEATURE_SPI_FLASH
+
+#include "spi_flash.h"
+#include "em_usart.h"
+#include "mx25flash_spi.h"
+
+/* Write in progress bit of the status register */
+#define STATUS_WIP 0x01
+#define PAGES_PER_SECTOR (SPI_FLASH_SECTOR_SIZE / SPI_FLASH_PAGE_SIZE)
+
+static uint8 users;
+
+static void waitIdle(void) {
+	while (spiFlash_IsBusy())
+		;
+}
+
+void spiFlash_Acquire(void) {
+	if (users++ > 0) {
+		return;
+	}
+	MX25_init();
+	MX25_RDP();
+	/* The status reads take longer than the wake up time */
+	waitIdle();
+}
+
+void spiFlash_Release(void) {
+	if (users == 0 || --users > 0) {
+		return;
+	}
+	waitIdle();
+	MX25_DP();
+	USART_Reset(USART1);
+}
+
+bool spiFlash_IsBusy(void) {
+	return (MX25_RDSR() & STATUS_WIP) != 0;
+}
+
+void spiFlash_ProgramStart(uint32 address, const uint8 *data, uint16 len) {
+	MX25_WREN();
+	MX25_PP(address, (uint8 *) data, len);
+}
+
+void spiFlash_EraseStart(uint32 address) {
+	MX25_WREN();
+	MX25_SE(address & ~(SPI_FLASH_SECTOR_SIZE - 1));
+}
+
+void spiFlash_Read(uint32 address, uint8 *data, uint32 len) {
+	waitIdle();
+	MX25_READ(address, data, len);
+}
+
+static uint32 pageAddress(const SpiFlashWriter *writer, uint32 page) {
+	return writer->address + (page % writer->regionPages) * SPI_FLASH_PAGE_SIZE;
+}
+
+static bool eraseAheadNeeded(const SpiFlashWriter *writer) {
+	return writer->erased < writer->limit && writer->erased < writer->written + writer->eraseAhead;
+}
+
+static void eraseNext(SpiFlashWriter *writer) {
+	spiFlash_EraseStart(pageAddress(writer, writer->erased));
+	writer->erased += PAGES_PER_SECTOR;
+}
+
+void spiFlash_WriterReset(SpiFlashWriter *writer, uint32 written, uint32 erased) {
+	writer->written = written;
+	writer->erased = erased;
+	writer->fillPage = 0;
+	writer->programPage = 0;
+	writer->pagesQueued = 0;
+	writer->programming = false;
+}
+
+void spiFlash_WriterQueue(SpiFlashWriter *writer) {
+	writer->pagesQueued++;
+	writer->fillPage = (writer->fillPage + 1) % writer->pageCount;
+}
+
+bool spiFlash_WriterHasWork(const SpiFlashWriter *writer) {
+	return writer->programming || writer->pagesQueued > 0 || eraseAheadNeeded(writer);
+}
+
+bool spiFlash_WriterPump(SpiFlashWriter *writer) {
+	if (spiFlash_IsBusy()) {
+		return true;
+	}
+	if (writer->programming) {
+		writer->programming = false;
+		writer->written++;
+		writer->programPage = (writer->programPage + 1) % writer->pageCount;
+		writer->pagesQueued--;
+	}
+	if (writer->pagesQueued > 0) {
+		if (writer->written >= writer->erased) {
+			eraseNext(writer);
+		} else {
+			uint8 *page = writer->pages[writer->programPage];
+			if (writer->prepare) {
+				writer->prepare(page, writer->written);
+			}
+			spiFlash_ProgramStart(pageAddress(writer, writer->written), page, SPI_FLASH_PAGE_SIZE);
+			writer->programming = true;
+		}
+		return true;
+	}
+	if (eraseAheadNeeded(writer)) {
+		/* Nothing to program, so get the next sector ready */
+		eraseNext(writer);
+		return true;
+	}
+	return false;
+}
+
+#endif /* FEATURE_SPI_FLASH */
@@ -0,0 +1,182 @@
+/*****************************************************************************
+ * @file spi_flash.h
+ * @brief Shared access to the MX25 SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef SPI_FLASH_H_
+#define SPI_FLASH_H_
+
+#include "bg_types.h"
+
+/* Program and erase commands only start the operation. The flash programs
+ * internally while the CPU carries on, so callers poll spiFlash_IsBusy()
+ * before issuing the next command, e.g. from a soft timer.
+ *
+ * The flash is kept in deep power down and the USART is reset between
+ * bursts. spiFlash_Acquire() wakes it and spiFlash_Release() puts it back to
+ * sleep when the last user releases it.
+ *
+ * A SpiFlashWriter programs a region page by page, in order, from a ring of
+ * page buffers. Sectors are erased just before the first page in them is
+ * programmed, and while there is nothing to program the writer erases ahead,
+ * so the next pages can be programmed straight away.
+ */
+
+#define SPI_FLASH_PAGE_SIZE 256
+#define SPI_FLASH_SECTOR_SIZE 4096
+#define SPI_FLASH_SIZE 0x100000
+
+/** Upgrade image slots, one after the other. Must match the storage slots of the Gecko bootloader. */
+#ifndef SPI_FLASH_IMAGE_SLOT_ADDRESS
+#define SPI_FLASH_IMAGE_SLOT_ADDRESS 0x00000
+#endif
+#ifndef SPI_FLASH_IMAGE_SLOT_SIZE
+#define SPI_FLASH_IMAGE_SLOT_SIZE 0x40000
+#endif
+#ifndef SPI_FLASH_IMAGE_SLOTS
+#define SPI_FLASH_IMAGE_SLOTS 2
+#endif
+
+/** A SpiFlashWriter limit that never stops it */
+#define SPI_FLASH_NO_LIMIT 0xFFFFFFFF
+
+typedef struct {
+	/** Start of the region, sector aligned */
+	uint32 address;
+	/** Region size in pages, whole sectors. Page numbers wrap around it. */
+	uint32 regionPages;
+	/** Pages from this one on are never erased, or SPI_FLASH_NO_LIMIT */
+	uint32 limit;
+	/** Pages to keep erased ahead of the written ones, whole sectors */
+	uint32 eraseAhead;
+	/** The page buffers */
+	uint8 (*pages)[SPI_FLASH_PAGE_SIZE];
+	uint8 pageCount;
+	/** Called with the page number just before a page is programmed, or NULL */
+	void (*prepare)(uint8 *page, uint32 number);
+
+	/** Number of the next page to program */
+	uint32 written;
+	/** Pages before this one are erased, always at a sector boundary */
+	uint32 erased;
+	/** Buffer being filled, oldest full buffer, and number of full buffers */
+	uint8 fillPage;
+	uint8 programPage;
+	uint8 pagesQueued;
+	bool programming;
+} SpiFlashWriter;
+
+/***************************************************************************//**
+ * @brief
+ *   Wake the flash from deep power down if this is the first user.
+ ******************************************************************************/
+void spiFlash_Acquire(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Put the flash into deep power down if this was the last user. Waits for a
+ *   program or erase in progress to finish.
+ ******************************************************************************/
+void spiFlash_Release(void);
+
+/***************************************************************************//**
+ * @brief
+ *   True while a program or erase is in progress.
+ ******************************************************************************/
+bool spiFlash_IsBusy(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Start programming up to a page. The data is sent before returning, so the
+ *   buffer can be reused straight away.
+ *
+ * @param[in] address
+ *   The address. The data must not cross a page boundary.
+ *
+ * @param[in] data
+ *   The data.
+ *
+ * @param[in] len
+ *   The number of bytes, at most SPI_FLASH_PAGE_SIZE.
+ ******************************************************************************/
+void spiFlash_ProgramStart(uint32 address, const uint8 *data, uint16 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Start erasing the sector containing an address.
+ ******************************************************************************/
+void spiFlash_EraseStart(uint32 address);
+
+/***************************************************************************//**
+ * @brief
+ *   Read from the flash. Waits for a program or erase in progress to finish.
+ ******************************************************************************/
+void spiFlash_Read(uint32 address, uint8 *data, uint32 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Empty the page buffers and set where the writer carries on from.
+ *
+ * @param[in] writer
+ *   The writer, with its region and buffers set.
+ *
+ * @param[in] written
+ *   Number of the next page to program.
+ *
+ * @param[in] erased
+ *   Pages before this one are erased. Must be at a sector boundary.
+ ******************************************************************************/
+void spiFlash_WriterReset(SpiFlashWriter *writer, uint32 written, uint32 erased);
+
+/***************************************************************************//**
+ * @brief
+ *   Queue the buffer being filled, writer->pages[writer->fillPage], for
+ *   programming. There must be a free buffer, pagesQueued < pageCount.
+ ******************************************************************************/
+void spiFlash_WriterQueue(SpiFlashWriter *writer);
+
+/***************************************************************************//**
+ * @brief
+ *   True while there are pages to program, or sectors to erase ahead.
+ ******************************************************************************/
+bool spiFlash_WriterHasWork(const SpiFlashWriter *writer);
+
+/***************************************************************************//**
+ * @brief
+ *   Finish the last operation and start the next one, without waiting. Call
+ *   until it returns false, with the flash acquired.
+ *
+ * @return
+ *   True while the flash is working.
+ ******************************************************************************/
+bool spiFlash_WriterPump(SpiFlashWriter *writer);
+
+#endif /* SPI_FLASH_H_ */
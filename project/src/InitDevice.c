@@ -162,6 +162,9 @@ extern void CMU_enter_DefaultMode_from_RESET(void) {
 	/* Enable clock for ADC0 */
 	CMU_ClockEnable(cmuClock_ADC0, true);
 
+	/* Enable clock for CRYPTO */
+	CMU_ClockEnable(cmuClock_CRYPTO, true);
+
 	/* Enable clock for GPCRC */
 	CMU_ClockEnable(cmuClock_GPCRC, true);
 
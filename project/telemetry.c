@@ -0,0 +1,202 @@
+/*****************************************************************************
+ * @file telemetry.c
+ * @brief Sealed telemetry records
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "telemetry.h"
+#include "util.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "gatt_db.h"
+#include "aes_ccm.h"
+#include "logging.h"
+
+#define MAX_CONNECTION_HANDLES 8
+#define MAX_MESSAGE_COUNT 0xFFFFFF
+
+static uint8 key[AES_CCM_KEY_LENGTH];
+static bd_addr address;
+static uint32 bootCount;
+static uint32 messageCount;
+/* Key made and boot count saved, so records can be sealed */
+static bool keyReady;
+static bool countReady;
+/* The CRYPTO peripheral passed its self test */
+static bool cipherReady;
+static bool authenticated[MAX_CONNECTION_HANDLES];
+
+static void loadKey(void) {
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(TELEMETRY_KEY_PS_KEY);
+	if (rsp->result == bg_err_success && rsp->value.len == sizeof(key)) {
+		memcpy(key, rsp->value.data, sizeof(key));
+		keyReady = true;
+		return;
+	}
+	uint8 len = 0;
+	while (len < sizeof(key)) {
+		struct gecko_msg_system_get_random_data_rsp_t *random = gecko_cmd_system_get_random_data(sizeof(key) - len);
+		if (random->result != bg_err_success) {
+			LogWarn("Could not generate telemetry key: 0x%x", random->result);
+			return;
+		}
+		memcpy(&key[len], random->data.data, random->data.len);
+		len += random->data.len;
+	}
+	uint16 result = gecko_cmd_flash_ps_save(TELEMETRY_KEY_PS_KEY, sizeof(key), key)->result;
+	if (result != bg_err_success) {
+		/* Still usable, but clients will need to read it again after a reset */
+		LogWarn("Could not save telemetry key: 0x%x", result);
+	}
+	keyReady = true;
+	LogInfo("New telemetry key");
+}
+
+/* Start a new nonce space. Called on every boot and when the message count
+ * runs out. Unless the count is saved, a reset would reuse it. */
+static void nextBoot(void) {
+	bootCount++;
+	messageCount = 0;
+	uint8 value[4];
+	putUint32(value, bootCount);
+	uint16 result = gecko_cmd_flash_ps_save(TELEMETRY_BOOT_COUNT_PS_KEY, sizeof(value), value)->result;
+	countReady = result == bg_err_success;
+	if (!countReady) {
+		LogWarn("Could not save boot count: 0x%x, not sealing", result);
+	}
+}
+
+/* Write the header for the next record and the nonce made from it. False if nothing can be sealed. */
+static bool nextHeader(uint8 *header, uint8 *nonce) {
+	if (messageCount > MAX_MESSAGE_COUNT) {
+		nextBoot();
+	}
+	if (!telemetry_Ready()) {
+		return false;
+	}
+	putUint32(header, bootCount);
+	header[4] = messageCount;
+	header[5] = messageCount >> 8;
+	header[6] = messageCount >> 16;
+	messageCount++;
+	memcpy(nonce, address.addr, sizeof(address.addr));
+	memcpy(&nonce[sizeof(address.addr)], header, TELEMETRY_HEADER_LENGTH);
+	return true;
+}
+
+void telemetry_Init(void) {
+	address = gecko_cmd_system_get_bt_address()->address;
+	loadKey();
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(TELEMETRY_BOOT_COUNT_PS_KEY);
+	if (rsp->result == bg_err_success && rsp->value.len == 4) {
+		bootCount = getUint32(rsp->value.data);
+	}
+	nextBoot();
+	LogInfo("Telemetry boot %lu", bootCount);
+}
+
+void telemetry_SelfTested(bool passed) {
+	cipherReady = passed;
+	if (!passed) {
+		LogWarn("AES-CCM self test failed, not sealing");
+	}
+}
+
+bool telemetry_Ready(void) {
+	return keyReady && countReady && cipherReady;
+}
+
+uint16 telemetry_Seal(uint8 *record, uint16 payloadLength, const uint8 *aad, uint8 aadLength) {
+	uint8 nonce[AES_CCM_NONCE_LENGTH];
+	if (!nextHeader(record, nonce)) {
+		return 0;
+	}
+	AesCcmRecord r = {
+		.data = &record[TELEMETRY_HEADER_LENGTH],
+		.len = payloadLength,
+		.aad = aad,
+		.aadLen = aadLength,
+		.nonce = nonce,
+		.tag = &record[TELEMETRY_HEADER_LENGTH + payloadLength],
+	};
+	aesCcm_Encrypt(key, &r, TELEMETRY_TAG_LENGTH);
+	return payloadLength + TELEMETRY_OVERHEAD;
+}
+
+bool telemetry_SealBatch(uint8 *records, uint16 recordLength, uint16 count) {
+	uint8 nonces[TELEMETRY_MAX_BATCH][AES_CCM_NONCE_LENGTH];
+	AesCcmRecord batch[TELEMETRY_MAX_BATCH];
+	const uint16 payloadLength = recordLength - TELEMETRY_OVERHEAD;
+	while (count > 0) {
+		uint8 n = count > TELEMETRY_MAX_BATCH ? TELEMETRY_MAX_BATCH : count;
+		for (uint8 i = 0; i < n; i++) {
+			uint8 *record = &records[i * recordLength];
+			if (!nextHeader(record, nonces[i])) {
+				return false;
+			}
+			batch[i] = (AesCcmRecord) {
+				.data = &record[TELEMETRY_HEADER_LENGTH],
+				.len = payloadLength,
+				.nonce = nonces[i],
+				.tag = &record[TELEMETRY_HEADER_LENGTH + payloadLength],
+			};
+		}
+		aesCcm_EncryptBatch(key, batch, n, TELEMETRY_TAG_LENGTH);
+		records += n * recordLength;
+		count -= n;
+	}
+	return true;
+}
+
+void telemetry_ConnectionOpened(uint8 connection) {
+	if (connection < MAX_CONNECTION_HANDLES) {
+		authenticated[connection] = false;
+	}
+}
+
+void telemetry_ConnectionParameters(uint8 connection, uint8 securityMode) {
+	if (connection < MAX_CONNECTION_HANDLES) {
+		/* Level 3 and up are encrypted with an authenticated key */
+		authenticated[connection] = securityMode >= le_connection_mode1_level3;
+	}
+}
+
+void telemetry_KeyRead(uint8 connection, uint16 offset) {
+	if (connection >= MAX_CONNECTION_HANDLES || !authenticated[connection]) {
+		/* Clients that can't read it pair with a passkey and retry */
+		gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_telemetry_key, (uint8) bg_err_att_insufficient_authentication, 0, NULL);
+	} else if (!keyReady) {
+		gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_telemetry_key, (uint8) bg_err_att_application, 0, NULL);
+	} else if (offset > sizeof(key)) {
+		gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_telemetry_key, (uint8) bg_err_att_invalid_offset, 0, NULL);
+	} else {
+		gecko_cmd_gatt_server_send_user_read_response(connection, gattdb_telemetry_key, bg_err_success, sizeof(key) - offset, &key[offset]);
+	}
+}
@@ -0,0 +1,142 @@
+/*****************************************************************************
+ * @file telemetry.h
+ * @brief Sealed telemetry records
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include "bg_types.h"
+
+/* Telemetry records are encrypted and authenticated with AES-CCM under a
+ * device key, independently of link layer security, so they can be carried
+ * in advertising data or relayed by untrusted gateways.
+ *
+ * A sealed record is
+ *   <uint32 boot count> <uint24 message count> <ciphertext> <tag>
+ * with the counts little endian. The nonce is the device address followed by
+ * the header, so it never repeats: the boot count is persisted and increments
+ * on every boot and whenever the message count wraps.
+ *
+ * The key is generated on first boot and kept in a PS key. Clients read it
+ * from the telemetry key characteristic, which needs a link encrypted with an
+ * authenticated (MITM protected) key. tools/aes_ccm.py opens records on the host.
+ *
+ * Nothing is sealed if the key could not be generated, or if the boot count
+ * could not be saved, as the nonces could then repeat after a reset.
+ */
+
+#define TELEMETRY_HEADER_LENGTH 7
+#define TELEMETRY_TAG_LENGTH 4
+/** Bytes a sealed record adds to its payload. */
+#define TELEMETRY_OVERHEAD (TELEMETRY_HEADER_LENGTH + TELEMETRY_TAG_LENGTH)
+
+/** Most records sealed per call to the CRYPTO peripheral by telemetry_SealBatch(). */
+#ifndef TELEMETRY_MAX_BATCH
+#define TELEMETRY_MAX_BATCH 8
+#endif
+
+#ifndef TELEMETRY_KEY_PS_KEY
+#define TELEMETRY_KEY_PS_KEY 0x4040
+#endif
+
+#ifndef TELEMETRY_BOOT_COUNT_PS_KEY
+#define TELEMETRY_BOOT_COUNT_PS_KEY 0x4041
+#endif
+
+/***************************************************************************//**
+ * @brief
+ *   Load or create the key and count this boot. Call from gecko_evt_system_boot()
+ *   before anything is sealed.
+ ******************************************************************************/
+void telemetry_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Record the result of the AES-CCM self test, see aesCcm_Init(). Nothing is
+ *   sealed until it has passed.
+ ******************************************************************************/
+void telemetry_SelfTested(bool passed);
+
+/***************************************************************************//**
+ * @brief
+ *   Whether records can be sealed.
+ ******************************************************************************/
+bool telemetry_Ready(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Seal a record in place.
+ *
+ * @param[in,out] record
+ *   TELEMETRY_HEADER_LENGTH bytes of space, then the payload, then
+ *   TELEMETRY_TAG_LENGTH bytes of space.
+ *
+ * @param[in] payloadLength
+ *   Length of the payload.
+ *
+ * @param[in] aad
+ *   Data authenticated with the record but sent separately, may be NULL.
+ *
+ * @param[in] aadLength
+ *   Length of @p aad.
+ *
+ * @return
+ *   The sealed record length, payloadLength + TELEMETRY_OVERHEAD, or 0 if it
+ *   could not be sealed (see telemetry_Ready()).
+ ******************************************************************************/
+uint16 telemetry_Seal(uint8 *record, uint16 payloadLength, const uint8 *aad, uint8 aadLength);
+
+/***************************************************************************//**
+ * @brief
+ *   Seal consecutive records of the same length in place, as telemetry_Seal()
+ *   without additional data.
+ *
+ * @param[in,out] records
+ *   @p count records of @p recordLength bytes, laid out as for telemetry_Seal().
+ *
+ * @param[in] recordLength
+ *   Length of each sealed record, including TELEMETRY_OVERHEAD.
+ *
+ * @param[in] count
+ *   Number of records.
+ *
+ * @return
+ *   False if the records could not be sealed (see telemetry_Ready()).
+ ******************************************************************************/
+bool telemetry_SealBatch(uint8 *records, uint16 recordLength, uint16 count);
+
+/* Event hooks, called from the corresponding gecko events */
+void telemetry_ConnectionOpened(uint8 connection);
+void telemetry_ConnectionParameters(uint8 connection, uint8 securityMode);
+void telemetry_KeyRead(uint8 connection, uint16 offset);
+
+#endif /* TELEMETRY_H_ */
@@ -0,0 +1,328 @@
+/*****************************************************************************
+ * @file throughput.c
+ * @brief High throughput bulk transfer over the stream characteristic
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "throughput.h"
+#include "util.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "gatt_db.h"
+#include "app_timer.h"
+#include "telemetry.h"
+#include "logging.h"
+
+#if (THROUGHPUT_BUFFER_SIZE & (THROUGHPUT_BUFFER_SIZE - 1)) != 0
+#error THROUGHPUT_BUFFER_SIZE must be a power of two
+#endif
+
+#if THROUGHPUT_RECORD_LENGTH <= TELEMETRY_OVERHEAD
+#error THROUGHPUT_RECORD_LENGTH must leave room for a payload
+#endif
+
+#define MAX_CONNECTION_HANDLES 8
+#define DEFAULT_MTU 23
+#define ATT_NOTIFICATION_HEADER_LENGTH 3
+#define PHY_2M 0x02
+/* Retry period when the stack has no free buffers. A few ms is less than a connection interval. */
+#define PUMP_RETRY_TICKS TIMER_MS_2_TIMERTICK(5)
+
+#define RECORD_PAYLOAD_LENGTH (THROUGHPUT_RECORD_LENGTH - TELEMETRY_OVERHEAD)
+
+/* Transmit ring buffer. head and tail run freely and are masked on access,
+ * which works because the buffer size divides the uint16 range. */
+static uint8 buffer[THROUGHPUT_BUFFER_SIZE];
+static uint16 head;
+static uint16 tail;
+
+static uint16 mtus[MAX_CONNECTION_HANDLES];
+static uint8 streamConnection = NO_CONNECTION;
+static uint8 controlConnection = NO_CONNECTION;
+static bool pumpScheduled;
+
+static struct {
+	ThroughputCommand command;
+	/* Pattern bytes still to be generated for a send benchmark */
+	uint32 remaining;
+	uint32 bytes;
+	uint32 startTime;
+} benchmark;
+
+static uint16 mtuForConnection(uint8 connection) {
+	if (connection >= MAX_CONNECTION_HANDLES || mtus[connection] == 0) {
+		return DEFAULT_MTU;
+	}
+	return mtus[connection];
+}
+
+static void benchmarkReport(void) {
+	uint32 ms = TIMER_TIMERTICK_2_MS(appTimerNow() - benchmark.startTime);
+	uint32 kbps = ms ? (benchmark.bytes * 8) / ms : 0;
+	LogInfo("Benchmark %d: %lu bytes in %lu ms, %lu kbit/s", benchmark.command, benchmark.bytes, ms, kbps);
+	if (controlConnection != NO_CONNECTION) {
+		uint8 report[13];
+		report[0] = benchmark.command;
+		putUint32(&report[1], benchmark.bytes);
+		putUint32(&report[5], ms);
+		putUint32(&report[9], kbps);
+		gecko_cmd_gatt_server_send_characteristic_notification(controlConnection, gattdb_stream_control, sizeof(report), report);
+	}
+	benchmark.command = ThroughputCommandStop;
+	benchmark.remaining = 0;
+}
+
+/* Top up the ring buffer with test pattern while a send benchmark is running */
+static void benchmarkFill(void) {
+	while (benchmark.remaining > 0 && head - tail < THROUGHPUT_BUFFER_SIZE) {
+		uint16 offset = head & (THROUGHPUT_BUFFER_SIZE - 1);
+		uint16 len = MIN(THROUGHPUT_BUFFER_SIZE - (uint16)(head - tail), THROUGHPUT_BUFFER_SIZE - offset);
+		if (len > benchmark.remaining) {
+			len = benchmark.remaining;
+		}
+		for (uint16 i = 0; i < len; i++) {
+			buffer[offset + i] = (uint8)(head + i);
+		}
+		head += len;
+		benchmark.remaining -= len;
+	}
+}
+
+/* As benchmarkFill(), sealing a batch of records at a time */
+static void benchmarkFillSealed(void) {
+	static uint8 records[TELEMETRY_MAX_BATCH * THROUGHPUT_RECORD_LENGTH];
+	while (benchmark.remaining > 0 && throughput_Space() >= THROUGHPUT_RECORD_LENGTH) {
+		uint16 count = MIN(throughput_Space() / THROUGHPUT_RECORD_LENGTH, TELEMETRY_MAX_BATCH);
+		uint32 needed = (benchmark.remaining + THROUGHPUT_RECORD_LENGTH - 1) / THROUGHPUT_RECORD_LENGTH;
+		count = MIN(count, needed);
+		for (uint16 i = 0; i < count; i++) {
+			uint8 *payload = &records[i * THROUGHPUT_RECORD_LENGTH + TELEMETRY_HEADER_LENGTH];
+			for (uint16 j = 0; j < RECORD_PAYLOAD_LENGTH; j++) {
+				payload[j] = (uint8) j;
+			}
+		}
+		if (!telemetry_SealBatch(records, THROUGHPUT_RECORD_LENGTH, count)) {
+			/* End the benchmark with what was already sealed */
+			LogWarn("Could not seal records, ending the benchmark");
+			benchmark.remaining = 0;
+			return;
+		}
+		/* Copied in rather than sealed in place, as a record may span the wrap */
+		uint16 len = count * THROUGHPUT_RECORD_LENGTH;
+		uint16 offset = head & (THROUGHPUT_BUFFER_SIZE - 1);
+		uint16 first = MIN(len, THROUGHPUT_BUFFER_SIZE - offset);
+		memcpy(&buffer[offset], records, first);
+		memcpy(buffer, records + first, len - first);
+		head += len;
+		benchmark.remaining = benchmark.remaining > len ? benchmark.remaining - len : 0;
+	}
+}
+
+/* Drop what is left for the stream client, reporting any benchmark cut short */
+static void stopStream(void) {
+	streamConnection = NO_CONNECTION;
+	tail = head;
+	if (benchmark.command == ThroughputCommandSend || benchmark.command == ThroughputCommandSendSealed) {
+		benchmarkReport();
+	}
+}
+
+static void schedulePump(void) {
+	if (!pumpScheduled) {
+		pumpScheduled = true;
+		gecko_cmd_hardware_set_soft_timer(PUMP_RETRY_TICKS, AppTimerIDThroughputPump, true);
+	}
+}
+
+void throughput_Init(void) {
+	uint16 result = gecko_cmd_gatt_set_max_mtu(THROUGHPUT_MTU)->result;
+	if (result != bg_err_success) {
+		LogWarn("Could not set max MTU: 0x%x", result);
+	}
+}
+
+uint16 throughput_Space(void) {
+	return THROUGHPUT_BUFFER_SIZE - (uint16)(head - tail);
+}
+
+uint16 throughput_Write(const uint8 *data, uint16 len) {
+	uint16 space = throughput_Space();
+	if (len > space) {
+		len = space;
+	}
+	uint16 offset = head & (THROUGHPUT_BUFFER_SIZE - 1);
+	uint16 first = MIN(len, THROUGHPUT_BUFFER_SIZE - offset);
+	memcpy(&buffer[offset], data, first);
+	memcpy(buffer, data + first, len - first);
+	head += len;
+	throughput_Pump();
+	return len;
+}
+
+void throughput_Pump(void) {
+	pumpScheduled = false;
+	if (streamConnection == NO_CONNECTION) {
+		return;
+	}
+	const uint16 maxLen = mtuForConnection(streamConnection) - ATT_NOTIFICATION_HEADER_LENGTH;
+	while (1) {
+		if (benchmark.command == ThroughputCommandSendSealed) {
+			benchmarkFillSealed();
+		} else {
+			benchmarkFill();
+		}
+		if (throughput_Refill) {
+			throughput_Refill();
+		}
+		uint16 used = head - tail;
+		if (used == 0) {
+			break;
+		}
+		/* Send straight out of the ring buffer, so a packet never spans the wrap */
+		uint16 offset = tail & (THROUGHPUT_BUFFER_SIZE - 1);
+		uint16 len = MIN(used, THROUGHPUT_BUFFER_SIZE - offset);
+		len = MIN(len, maxLen);
+		uint16 result = gecko_cmd_gatt_server_send_characteristic_notification(streamConnection, gattdb_stream, len, &buffer[offset])->result;
+		if (result == bg_err_out_of_memory) {
+			/* Stack buffers are full, try again once some packets have gone out */
+			schedulePump();
+			return;
+		} else if (result != bg_err_success) {
+			/* Retrying won't help, so stop rather than leave the data stuck in the buffer */
+			LogWarn("Stream notification failed: 0x%x, stopping the stream", result);
+			stopStream();
+			return;
+		}
+		tail += len;
+		if (benchmark.command == ThroughputCommandSend || benchmark.command == ThroughputCommandSendSealed) {
+			benchmark.bytes += len;
+		}
+	}
+	if ((benchmark.command == ThroughputCommandSend || benchmark.command == ThroughputCommandSendSealed) && benchmark.remaining == 0) {
+		benchmarkReport();
+	}
+}
+
+void throughput_ConnectionOpened(uint8 connection) {
+	if (connection < MAX_CONNECTION_HANDLES) {
+		mtus[connection] = DEFAULT_MTU;
+	}
+	/* Not all radios support 2M PHY, in which case the link stays on 1M */
+	uint16 result = gecko_cmd_le_connection_set_phy(connection, PHY_2M)->result;
+	if (result != bg_err_success) {
+		LogInfo("2M PHY not available: 0x%x", result);
+	}
+}
+
+void throughput_ConnectionClosed(uint8 connection) {
+	if (connection == streamConnection) {
+		streamConnection = NO_CONNECTION;
+		/* Anything left in the buffer was meant for this client */
+		tail = head;
+		benchmark.command = ThroughputCommandStop;
+		benchmark.remaining = 0;
+	}
+	if (connection == controlConnection) {
+		controlConnection = NO_CONNECTION;
+	}
+}
+
+void throughput_MtuExchanged(uint8 connection, uint16 mtu) {
+	LogInfo("MTU %d on connection %d", mtu, connection);
+	if (connection < MAX_CONNECTION_HANDLES) {
+		mtus[connection] = mtu;
+	}
+}
+
+void throughput_PhyStatus(uint8 connection, uint8 phy) {
+	LogInfo("PHY %d on connection %d", phy, connection);
+}
+
+void throughput_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+	if (status_flags != gatt_server_client_config) {
+		return;
+	}
+	bool enabled = client_config_flags & gatt_notification;
+	if (characteristic == gattdb_stream) {
+		streamConnection = enabled ? connection : NO_CONNECTION;
+		if (enabled) {
+			/* Shortest interval for as many packets per second as possible while streaming */
+			gecko_cmd_le_connection_set_parameters(connection, THROUGHPUT_CONNECTION_INTERVAL, THROUGHPUT_CONNECTION_INTERVAL, 0, 100);
+			throughput_Pump();
+		}
+	} else if (characteristic == gattdb_stream_control) {
+		controlConnection = enabled ? connection : NO_CONNECTION;
+	}
+}
+
+void throughput_StreamWrite(uint8 connection, uint8 len, const uint8 *data) {
+	if (benchmark.command == ThroughputCommandReceive) {
+		if (benchmark.bytes == 0) {
+			benchmark.startTime = appTimerNow();
+		}
+		benchmark.bytes += len;
+	}
+	if (throughput_DataReceived) {
+		throughput_DataReceived(data, len);
+	}
+}
+
+uint8 throughput_ControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	if (len < 1) {
+		return (uint8) bg_err_att_invalid_att_length;
+	}
+	switch ((ThroughputCommand) data[0]) {
+	case ThroughputCommandStop:
+		if (benchmark.command != ThroughputCommandStop) {
+			benchmarkReport();
+		}
+		break;
+	case ThroughputCommandSend:
+	case ThroughputCommandSendSealed:
+		if (len < 5) {
+			return (uint8) bg_err_att_invalid_att_length;
+		}
+		benchmark.command = (ThroughputCommand) data[0];
+		benchmark.remaining = getUint32(&data[1]);
+		benchmark.bytes = 0;
+		benchmark.startTime = appTimerNow();
+		throughput_Pump();
+		break;
+	case ThroughputCommandReceive:
+		benchmark.command = ThroughputCommandReceive;
+		benchmark.remaining = 0;
+		/* The clock starts at the first received packet */
+		benchmark.bytes = 0;
+		break;
+	default:
+		return (uint8) bg_err_att_request_not_supported;
+	}
+	return bg_err_success;
+}
@@ -0,0 +1,152 @@
+/*****************************************************************************
+ * @file throughput.h
+ * @brief High throughput bulk transfer over the stream characteristic
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef THROUGHPUT_H_
+#define THROUGHPUT_H_
+
+#include "bg_types.h"
+
+/* Throughput mode negotiates the fastest link the peer supports as soon as a
+ * connection opens: 2M PHY (on radios that support it), the largest ATT MTU,
+ * and, as a consequence of the large MTU, the largest link layer data length.
+ *
+ * Data queued with throughput_Write() is notified on the stream characteristic
+ * straight out of a ring buffer, as many packets as the stack will accept at
+ * once. Writes without response to the stream characteristic are passed to
+ * throughput_DataReceived().
+ *
+ * Writing to the stream control characteristic runs a benchmark:
+ *   0x01 <uint32 length> - send length bytes of test pattern to the client
+ *   0x02                 - start counting bytes received from the client
+ *   0x03 <uint32 length> - as 0x01, in THROUGHPUT_RECORD_LENGTH byte records
+ *                          sealed with telemetry_SealBatch(), rounded up to
+ *                          whole records
+ *   0x00                 - stop the benchmark and report
+ * The report is notified on the stream control characteristic as
+ *   <uint8 command> <uint32 bytes> <uint32 milliseconds> <uint32 kbit/s>
+ * all little endian.
+ */
+
+/** Size of the transmit ring buffer in bytes. Must be a power of two. */
+#ifndef THROUGHPUT_BUFFER_SIZE
+#define THROUGHPUT_BUFFER_SIZE 4096
+#endif
+
+/** ATT MTU requested from the stack. 247 gives 244 byte notifications, which fit a 251 byte data length PDU. */
+#ifndef THROUGHPUT_MTU
+#define THROUGHPUT_MTU 247
+#endif
+
+/** Connection interval used while streaming, in units of 1.25ms. */
+#ifndef THROUGHPUT_CONNECTION_INTERVAL
+#define THROUGHPUT_CONNECTION_INTERVAL 6
+#endif
+
+/** Length of each sealed record sent by the 0x03 benchmark, including TELEMETRY_OVERHEAD. The stream is a plain concatenation of records. */
+#ifndef THROUGHPUT_RECORD_LENGTH
+#define THROUGHPUT_RECORD_LENGTH 64
+#endif
+
+typedef enum {
+	ThroughputCommandStop = 0x00,
+	ThroughputCommandSend = 0x01,
+	ThroughputCommandReceive = 0x02,
+	ThroughputCommandSendSealed = 0x03,
+} ThroughputCommand;
+
+/***************************************************************************//**
+ * @brief
+ *   Configure the stack for throughput mode. Call from gecko_evt_system_boot().
+ ******************************************************************************/
+void throughput_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Queue data to be notified on the stream characteristic.
+ *
+ * @param[in] data
+ *   The data to send.
+ *
+ * @param[in] len
+ *   Number of bytes in @p data.
+ *
+ * @return
+ *   The number of bytes queued, which is less than @p len if the buffer is full.
+ ******************************************************************************/
+uint16 throughput_Write(const uint8 *data, uint16 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Free space in the transmit buffer.
+ ******************************************************************************/
+uint16 throughput_Space(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Send as much of the transmit buffer as the stack will accept.
+ *
+ * @note
+ *   Called from the AppTimerIDThroughputPump soft timer. Only needs to be called
+ *   manually after queuing data outside of throughput_Write().
+ ******************************************************************************/
+void throughput_Pump(void);
+
+/* Event hooks, called from the corresponding gecko events */
+void throughput_ConnectionOpened(uint8 connection);
+void throughput_ConnectionClosed(uint8 connection);
+void throughput_MtuExchanged(uint8 connection, uint16 mtu);
+void throughput_PhyStatus(uint8 connection, uint8 phy);
+void throughput_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags);
+void throughput_StreamWrite(uint8 connection, uint8 len, const uint8 *data);
+uint8 throughput_ControlWrite(uint8 connection, uint8 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you can implement to receive data written to the stream characteristic.
+ *
+ * @param[in] data
+ *   The received data.
+ *
+ * @param[in] len
+ *   Number of bytes in @p data.
+ ******************************************************************************/
+void throughput_DataReceived(const uint8 *data, uint8 len) __attribute__((weak));
+
+/***************************************************************************//**
+ * @brief
+ *   A weak function that you can implement to top up the transmit buffer with
+ *   throughput_Write() as it drains. Called each time the buffer is sent.
+ ******************************************************************************/
+void throughput_Refill(void) __attribute__((weak));
+
+#endif /* THROUGHPUT_H_ */
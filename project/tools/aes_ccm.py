@@ -0,0 +1,184 @@
+#!/usr/bin/env python3
+#
+# aes_ccm.py
+# Host reference for aes_ccm.c and telemetry.c: AES-128 CCM in pure Python,
+# and a decoder for the sealed telemetry records the device sends.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# Usage:
+#   aes_ccm.py --check
+#       check the implementation against the FIPS-197 and RFC 3610 vectors
+#   aes_ccm.py open <key> <address> <record> [<aad>]
+#       decrypt a telemetry record. key, record and aad are hex, address is
+#       the device address as printed, e.g. 00:0b:57:12:34:56
+
+import sys
+
+NONCE_LENGTH = 13
+TELEMETRY_HEADER_LENGTH = 7
+TELEMETRY_TAG_LENGTH = 4
+
+
+def _xtime(a):
+    return ((a << 1) ^ (0x1B if a & 0x80 else 0)) & 0xFF
+
+
+def _sbox():
+    box = [0] * 256
+    p = q = 1
+    while True:
+        p = p ^ _xtime(p)
+        q ^= (q << 1) & 0xFF
+        q ^= (q << 2) & 0xFF
+        q ^= (q << 4) & 0xFF
+        if q & 0x80:
+            q ^= 0x09
+        rot = lambda v, n: ((v << n) | (v >> (8 - n))) & 0xFF
+        box[p] = q ^ rot(q, 1) ^ rot(q, 2) ^ rot(q, 3) ^ rot(q, 4) ^ 0x63
+        if p == 1:
+            break
+    box[0] = 0x63
+    return box
+
+
+SBOX = _sbox()
+
+
+def expand_key(key):
+    words = [list(key[i:i + 4]) for i in range(0, 16, 4)]
+    rcon = 1
+    for i in range(4, 44):
+        t = list(words[i - 1])
+        if i % 4 == 0:
+            t = [SBOX[t[1]] ^ rcon, SBOX[t[2]], SBOX[t[3]], SBOX[t[0]]]
+            rcon = _xtime(rcon)
+        words.append([a ^ b for a, b in zip(words[i - 4], t)])
+    return [sum(words[r * 4:r * 4 + 4], []) for r in range(11)]
+
+
+def encrypt_block(round_keys, block):
+    s = [a ^ b for a, b in zip(block, round_keys[0])]
+    for r in range(1, 11):
+        # SubBytes and ShiftRows: byte i is row i % 4 of column i // 4
+        s = [SBOX[s[(i + 4 * (i % 4)) % 16]] for i in range(16)]
+        if r < 10:
+            for c in range(0, 16, 4):
+                a = s[c:c + 4]
+                x = a[0] ^ a[1] ^ a[2] ^ a[3]
+                s[c:c + 4] = [a[j] ^ x ^ _xtime(a[j] ^ a[(j + 1) % 4]) for j in range(4)]
+        s = [a ^ b for a, b in zip(s, round_keys[r])]
+    return bytes(s)
+
+
+def _blocks(data):
+    data = bytes(data) + bytes(-len(data) % 16)
+    return [data[i:i + 16] for i in range(0, len(data), 16)]
+
+
+def _counter(nonce, i):
+    return bytes([1]) + nonce + i.to_bytes(2, "big")
+
+
+def _mac(round_keys, nonce, aad, data, tag_length):
+    b0 = bytes([(0x40 if aad else 0) | (((tag_length - 2) // 2) << 3) | 1]) + nonce + len(data).to_bytes(2, "big")
+    blocks = [b0]
+    if aad:
+        blocks += _blocks(len(aad).to_bytes(2, "big") + aad)
+    blocks += _blocks(data)
+    mac = bytes(16)
+    for block in blocks:
+        mac = encrypt_block(round_keys, [a ^ b for a, b in zip(mac, block)])
+    return mac
+
+
+def _ctr(round_keys, nonce, data):
+    out = bytearray()
+    for i in range(0, len(data), 16):
+        stream = encrypt_block(round_keys, _counter(nonce, i // 16 + 1))
+        out += bytes(a ^ b for a, b in zip(data[i:i + 16], stream))
+    return bytes(out)
+
+
+def _mask(round_keys, nonce, mac, tag_length):
+    s0 = encrypt_block(round_keys, _counter(nonce, 0))
+    return bytes(a ^ b for a, b in zip(mac, s0))[:tag_length]
+
+
+def encrypt(key, nonce, aad, data, tag_length):
+    """Return (ciphertext, tag)."""
+    round_keys = expand_key(key)
+    mac = _mac(round_keys, nonce, aad, data, tag_length)
+    return _ctr(round_keys, nonce, data), _mask(round_keys, nonce, mac, tag_length)
+
+
+def decrypt(key, nonce, aad, data, tag):
+    """Return the plaintext, or None if the tag does not match."""
+    round_keys = expand_key(key)
+    plain = _ctr(round_keys, nonce, data)
+    if _mask(round_keys, nonce, _mac(round_keys, nonce, aad, plain, len(tag)), len(tag)) != tag:
+        return None
+    return plain
+
+
+def open_record(key, address, record, aad=b""):
+    """Decrypt a record sealed by telemetry.c: header, ciphertext, tag.
+
+    address is the device address in over the air byte order (least
+    significant byte first). Returns (boot count, message count, plaintext)."""
+    header = record[:TELEMETRY_HEADER_LENGTH]
+    nonce = address + header
+    plain = decrypt(key, nonce, aad, record[TELEMETRY_HEADER_LENGTH:-TELEMETRY_TAG_LENGTH], record[-TELEMETRY_TAG_LENGTH:])
+    if plain is None:
+        return None
+    return int.from_bytes(header[:4], "little"), int.from_bytes(header[4:], "little"), plain
+
+
+def check():
+    key = bytes(range(16))
+    if encrypt_block(expand_key(key), bytes.fromhex("00112233445566778899aabbccddeeff")).hex() != "69c4e0d86a7b0430d8cdb78070b4c55a":
+        print("FAIL: FIPS-197 vector")
+        return 1
+    # RFC 3610 packet vectors #1 and #2
+    key = bytes(range(0xC0, 0xD0))
+    vectors = [
+        ("00000003020100a0a1a2a3a4a5", 31, "588c979a61c663d2f066d0c2c0f989806d5f6b61dac38417e8d12cfdf926e0"),
+        ("00000004030201a0a1a2a3a4a5", 32, "72c91a36e135f8cf291ca894085c87e3cc15c439c9e43a3ba091d56e10400916"),
+    ]
+    for nonce, length, expected in vectors:
+        nonce = bytes.fromhex(nonce)
+        aad = bytes(range(8))
+        data = bytes(range(8, length))
+        cipher, tag = encrypt(key, nonce, aad, data, 8)
+        if (cipher + tag).hex() != expected:
+            print("FAIL: RFC 3610 vector")
+            return 1
+        if decrypt(key, nonce, aad, cipher, tag) != data:
+            print("FAIL: decrypt")
+            return 1
+        if decrypt(key, nonce, aad, cipher, bytes([tag[0] ^ 1]) + tag[1:]) is not None:
+            print("FAIL: forged tag accepted")
+            return 1
+    print("OK")
+    return 0
+
+
+def main(argv):
+    if argv and argv[0] == "--check":
+        return check()
+    if len(argv) in (4, 5) and argv[0] == "open":
+        key = bytes.fromhex(argv[1])
+        address = bytes(reversed(bytes.fromhex(argv[2].replace(":", ""))))
+        aad = bytes.fromhex(argv[4]) if len(argv) == 5 else b""
+        result = open_record(key, address, bytes.fromhex(argv[3]), aad)
+        if result is None:
+            print("authentication failed")
+            return 1
+        print("boot %d message %d: %s" % (result[0], result[1], result[2].hex()))
+        return 0
+    print("usage: aes_ccm.py --check | open <key> <address> <record> [<aad>]")
+    return 2
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,62 @@
+#!/usr/bin/env python3
+#
+# crc32.py
+# Host reference for crc.c: CRC-32 of files, computed a nibble at a time
+# exactly as the software fallback on the device does.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# Usage:
+#   crc32.py <file>...   print the CRC-32 of each file
+#   crc32.py --check     check the implementation against the known value and zlib
+
+import random
+import sys
+import zlib
+
+NIBBLE_TABLE = [
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+]
+
+
+def crc32(data, crc=0):
+    crc ^= 0xFFFFFFFF
+    for byte in data:
+        crc ^= byte
+        crc = (crc >> 4) ^ NIBBLE_TABLE[crc & 0x0F]
+        crc = (crc >> 4) ^ NIBBLE_TABLE[crc & 0x0F]
+    return crc ^ 0xFFFFFFFF
+
+
+def check():
+    if crc32(b"123456789") != 0xCBF43926:
+        print("FAIL: check value")
+        return 1
+    if crc32(b"56789", crc32(b"1234")) != 0xCBF43926:
+        print("FAIL: continued CRC")
+        return 1
+    rng = random.Random(0)
+    for length in (0, 1, 3, 4, 255, 256, 257, 4096, 8195):
+        data = bytes(rng.getrandbits(8) for _ in range(length))
+        if crc32(data) != zlib.crc32(data) & 0xFFFFFFFF:
+            print("FAIL: %d bytes differ from zlib" % length)
+            return 1
+    print("OK")
+    return 0
+
+
+def main(argv):
+    if not argv:
+        print("usage: crc32.py <file>... | --check")
+        return 2
+    if argv[0] == "--check":
+        return check()
+    for path in argv:
+        with open(path, "rb") as f:
+            print("%08X  %s" % (crc32(f.read()), path))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,362 @@
+#!/usr/bin/env python3
+#
+# delta.py
+# Creates and applies delta upgrade images, see delta.h for the format.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# verify round trips a delta (created if not given) and checks the result
+# matches the new image byte for byte. --check builds the device decoder,
+# delta.c, for the host and checks it rebuilds images from deltas made here.
+
+import os
+import random
+import struct
+import subprocess
+import sys
+import tempfile
+import zlib
+
+USAGE = """usage:
+  delta.py create <reference image> <new image> <delta output>
+  delta.py apply <reference image> <delta> <image output>
+  delta.py verify <reference image> <new image> [delta]
+  delta.py --check [cc]"""
+
+MAGIC = b"BGDP"
+OP_LITERAL = 0x00
+OP_COPY_SOURCE = 0x01
+OP_COPY_TARGET = 0x02
+
+# Shortest match worth a copy operation. A copy costs 3-7 bytes.
+MIN_MATCH = 8
+# Bytes hashed to find match candidates
+KEY_LENGTH = 4
+# Candidates checked per position
+MAX_CANDIDATES = 32
+
+
+def crc32(data):
+    return zlib.crc32(data) & 0xFFFFFFFF
+
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def zigzag(value):
+    return (value << 1) ^ (value >> 31) if value < 0 else value << 1
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while True:
+        byte = data[pos]
+        pos += 1
+        value |= (byte & 0x7F) << shift
+        shift += 7
+        if not byte & 0x80:
+            return value, pos
+
+
+def index(data, limit=None):
+    table = {}
+    end = len(data) if limit is None else limit
+    for i in range(end - KEY_LENGTH + 1):
+        table.setdefault(data[i:i + KEY_LENGTH], []).append(i)
+    return table
+
+
+def match_length(a, a_pos, b, b_pos, limit):
+    n = 0
+    while n < limit and a[a_pos + n] == b[b_pos + n]:
+        n += 1
+    return n
+
+
+def create(source, target):
+    source_index = index(source)
+    target_index = {}
+    out = bytearray(MAGIC)
+    out += struct.pack("<IIII", len(source), crc32(source), len(target), crc32(target))
+    literal = bytearray()
+    source_offset = 0
+    pos = 0
+
+    def flush_literal():
+        if literal:
+            out.append(OP_LITERAL)
+            out.extend(varint(len(literal)))
+            out.extend(literal)
+            literal.clear()
+
+    def add_target_keys(start, end):
+        for i in range(max(start, 0), min(end, len(target) - KEY_LENGTH + 1)):
+            target_index.setdefault(target[i:i + KEY_LENGTH], []).append(i)
+
+    while pos < len(target):
+        best_len = 0
+        best_op = None
+        best_from = 0
+        key = target[pos:pos + KEY_LENGTH]
+        if len(key) == KEY_LENGTH:
+            # Prefer continuing the previous source copy, it encodes smallest
+            for s in [source_offset] + source_index.get(key, [])[-MAX_CANDIDATES:]:
+                if s + KEY_LENGTH > len(source):
+                    continue
+                n = match_length(source, s, target, pos, min(len(source) - s, len(target) - pos))
+                if n > best_len:
+                    best_len, best_op, best_from = n, OP_COPY_SOURCE, s
+            for t in target_index.get(key, [])[-MAX_CANDIDATES:]:
+                # Overlapping copies repeat the bytes, as the decoder does
+                n = 0
+                limit = len(target) - pos
+                while n < limit and target[t + n] == target[pos + n]:
+                    n += 1
+                if n > best_len:
+                    best_len, best_op, best_from = n, OP_COPY_TARGET, t
+        if best_len >= MIN_MATCH:
+            flush_literal()
+            out.append(best_op)
+            out.extend(varint(best_len))
+            if best_op == OP_COPY_SOURCE:
+                out.extend(varint(zigzag(best_from - source_offset)))
+                source_offset = best_from + best_len
+            else:
+                out.extend(varint(pos - best_from))
+            add_target_keys(pos - KEY_LENGTH + 1, pos + best_len - KEY_LENGTH + 1)
+            pos += best_len
+        else:
+            literal.append(target[pos])
+            add_target_keys(pos - KEY_LENGTH + 1, pos - KEY_LENGTH + 2)
+            pos += 1
+    flush_literal()
+    return bytes(out)
+
+
+def apply(source, delta):
+    if delta[:4] != MAGIC:
+        raise ValueError("not a delta image")
+    source_size, source_crc, target_size, target_crc = struct.unpack("<IIII", delta[4:20])
+    if source_size != len(source) or source_crc != crc32(source):
+        raise ValueError("delta was made from a different reference image")
+    target = bytearray()
+    source_offset = 0
+    pos = 20
+    while len(target) < target_size:
+        op = delta[pos]
+        length, pos = read_varint(delta, pos + 1)
+        if length == 0 or len(target) + length > target_size:
+            raise ValueError("bad length at %d" % pos)
+        if op == OP_LITERAL:
+            target += delta[pos:pos + length]
+            pos += length
+        elif op == OP_COPY_SOURCE:
+            value, pos = read_varint(delta, pos)
+            start = source_offset + ((value >> 1) ^ -(value & 1))
+            if start < 0 or start + length > len(source):
+                raise ValueError("source copy out of range at %d" % pos)
+            target += source[start:start + length]
+            source_offset = start + length
+        elif op == OP_COPY_TARGET:
+            distance, pos = read_varint(delta, pos)
+            if distance == 0 or distance > len(target):
+                raise ValueError("target copy out of range at %d" % pos)
+            start = len(target) - distance
+            for i in range(length):
+                target.append(target[start + i])
+        else:
+            raise ValueError("bad operation 0x%02x at %d" % (op, pos))
+    if crc32(target) != target_crc:
+        raise ValueError("target CRC mismatch")
+    return bytes(target)
+
+
+# Host build of delta.c: decode <delta> against <source> into <output>, with
+# the input split into small pieces and little output space per call, as on
+# the device. Exits with the decoder status.
+DRIVER = r"""
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "delta.h"
+
+static uint8 *source, *target;
+static uint32 written, capacity, turn;
+
+static uint8 *load(const char *path, uint32 *len) {
+	FILE *f = fopen(path, "rb");
+	if (!f) { exit(100); }
+	fseek(f, 0, SEEK_END);
+	*len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	uint8 *data = malloc(*len + 1);
+	if (fread(data, 1, *len, f) != *len) { exit(100); }
+	fclose(f);
+	return data;
+}
+
+static uint16 space(void) {
+	uint16 n = 1 + (turn * 37) % 300;
+	return written + n > capacity ? capacity - written : n;
+}
+
+static void write(const uint8 *data, uint16 len) {
+	if (written + len > capacity) { exit(101); }
+	memcpy(&target[written], data, len);
+	written += len;
+}
+
+static void readSource(uint32 offset, uint8 *data, uint16 len) {
+	memcpy(data, &source[offset], len);
+}
+
+static void readTarget(uint32 offset, uint8 *data, uint16 len) {
+	if (offset + len > written) { exit(102); }
+	memcpy(data, &target[offset], len);
+}
+
+int main(int argc, char **argv) {
+	uint32 sourceLength, deltaLength, pos = 0;
+	source = load(argv[1], &sourceLength);
+	uint8 *delta = load(argv[2], &deltaLength);
+	capacity = 16 << 20;
+	target = malloc(capacity);
+	static const DeltaIO io = { space, write, readSource, readTarget };
+	DeltaDecoder decoder;
+	delta_Init(&decoder);
+	uint32 idle = 0;
+	while (decoder.status == DeltaStatusOK && idle < 1000) {
+		uint32 len = pos < deltaLength ? 1 + (turn * 13) % 97 : 0;
+		if (len > deltaLength - pos) { len = deltaLength - pos; }
+		uint32 before = written;
+		uint32 consumed = delta_Decode(&decoder, &io, &delta[pos], len);
+		pos += consumed;
+		idle = consumed == 0 && written == before ? idle + 1 : 0;
+		turn++;
+	}
+	FILE *f = fopen(argv[3], "wb");
+	fwrite(target, 1, written, f);
+	fclose(f);
+	return decoder.status;
+}
+"""
+
+BG_TYPES = """#include <stdint.h>
+#include <stdbool.h>
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t int8;
+typedef int16_t int16;
+typedef int32_t int32;
+"""
+
+DELTA_STATUS_DONE = 1
+
+
+def mutate(rng, source):
+    """A new image sharing most of the reference, as after a code change."""
+    target = bytearray(source)
+    for _ in range(rng.randint(1, 20)):
+        pos = rng.randrange(len(target) + 1)
+        kind = rng.randrange(4)
+        if kind == 0:
+            target[pos:pos] = bytes(rng.randrange(256) for _ in range(rng.randint(1, 200)))
+        elif kind == 1:
+            del target[pos:pos + rng.randint(1, 300)]
+        elif kind == 2:
+            # Repeats within the new image, decoded as overlapping target copies
+            target[pos:pos] = bytes([rng.randrange(256)]) * rng.randint(10, 400)
+        else:
+            start = rng.randrange(len(source))
+            target[pos:pos] = source[start:start + rng.randint(8, 500)]
+    return bytes(target)
+
+
+def check(cc):
+    here = os.path.dirname(os.path.abspath(__file__))
+    project = os.path.dirname(here)
+    rng = random.Random(1)
+    with tempfile.TemporaryDirectory() as tmp:
+        def path(name):
+            return os.path.join(tmp, name)
+        write(path("bg_types.h"), BG_TYPES.encode())
+        write(path("driver.c"), DRIVER.encode())
+        result = subprocess.run([cc, "-std=gnu99", "-Wall", "-O1", "-I", tmp, "-I", project, path("driver.c"),
+                                 os.path.join(project, "delta.c"), "-o", path("decode")])
+        if result.returncode != 0:
+            print("FAIL: could not build delta.c")
+            return 1
+        cases = []
+        for _ in range(30):
+            source = bytes(rng.randrange(256) for _ in range(rng.randint(64, 20000)))
+            cases.append((source, mutate(rng, source)))
+        cases.append((b"\x00" * 1000, b"\x00" * 5000))
+        cases.append((bytes(range(256)) * 4, b"new image"))
+        for i, (source, target) in enumerate(cases):
+            delta = create(source, target)
+            write(path("source"), source)
+            write(path("delta"), delta)
+            status = subprocess.run([path("decode"), path("source"), path("delta"), path("target")]).returncode
+            if status != DELTA_STATUS_DONE or read(path("target")) != target:
+                print("FAIL: case %d, status %d" % (i, status))
+                return 1
+        # A corrupted operation must be rejected, not decoded
+        source, target = cases[0]
+        delta = bytearray(create(source, target))
+        delta[20] = 0x7F
+        write(path("delta"), bytes(delta))
+        if subprocess.run([path("decode"), path("source"), path("delta"), path("target")]).returncode == DELTA_STATUS_DONE:
+            print("FAIL: bad operation accepted")
+            return 1
+    print("OK: delta.c rebuilds %d images" % len(cases))
+    return 0
+
+
+def read(path):
+    with open(path, "rb") as f:
+        return f.read()
+
+
+def write(path, data):
+    with open(path, "wb") as f:
+        f.write(data)
+
+
+def main(argv):
+    if argv[:1] == ["--check"]:
+        return check(argv[1] if len(argv) > 1 else "cc")
+    if len(argv) < 3 or argv[0] not in ("create", "apply", "verify") or (argv[0] != "verify" and len(argv) < 4):
+        print(USAGE)
+        return 2
+    command = argv[0]
+    source = read(argv[1])
+    if command == "create":
+        target = read(argv[2])
+        delta = create(source, target)
+        write(argv[3], delta)
+        print("%s: %d bytes, %d%% of %d" % (argv[3], len(delta), len(delta) * 100 // max(len(target), 1), len(target)))
+    elif command == "apply":
+        write(argv[3], apply(source, read(argv[2])))
+    else:
+        target = read(argv[2])
+        delta = read(argv[3]) if len(argv) > 3 else create(source, target)
+        if apply(source, delta) != target:
+            print("FAIL: delta does not rebuild %s" % argv[2])
+            return 1
+        print("OK: %d byte delta rebuilds %s" % (len(delta), argv[2]))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+#
+# event_log.py
+# Decodes an event log read out, see event_log.h for the format.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# Usage:
+#   event_log.py <read out>   print the records, oldest first
+#   event_log.py --check      check decoding of generated pages
+
+import struct
+import sys
+import zlib
+
+PAGE_SIZE = 256
+PAGE_HEADER_LENGTH = 6
+PAGE_CRC_OFFSET = PAGE_SIZE - 4
+RECORD_HEADER_LENGTH = 6
+
+TYPE_BOOT = 0x01
+TYPE_CONNECTION_OPENED = 0x02
+TYPE_CONNECTION_CLOSED = 0x03
+TYPE_BUTTON = 0x04
+TYPE_HIBERNATE = 0x05
+TYPE_DROPPED = 0x06
+
+
+def describe(record_type, data):
+    if record_type == TYPE_BOOT and len(data) >= 1:
+        return "boot, %s" % ("warm" if data[0] else "cold")
+    if record_type == TYPE_CONNECTION_OPENED and len(data) >= 7:
+        address = ":".join("%02X" % b for b in reversed(data[1:7]))
+        return "connection %d opened by %s" % (data[0], address)
+    if record_type == TYPE_CONNECTION_CLOSED and len(data) >= 3:
+        return "connection %d closed, reason 0x%04x" % (data[0], data[1] | (data[2] << 8))
+    if record_type == TYPE_BUTTON and len(data) >= 2:
+        return "button %d %s" % (data[0], "output" if data[1] else "input")
+    if record_type == TYPE_HIBERNATE:
+        return "hibernate"
+    if record_type == TYPE_DROPPED and len(data) >= 4:
+        return "%d records dropped" % struct.unpack_from("<I", data)[0]
+    return "type 0x%02x %s" % (record_type, data.hex())
+
+
+def decode(readout):
+    """Returns (pages, records, bad pages) where each record is (sequence, milliseconds, type, data)."""
+    pages = 0
+    bad = 0
+    records = []
+    for offset in range(0, len(readout) - PAGE_SIZE + 1, PAGE_SIZE):
+        page = readout[offset:offset + PAGE_SIZE]
+        crc, = struct.unpack_from("<I", page, PAGE_CRC_OFFSET)
+        sequence, length = struct.unpack_from("<IH", page)
+        if zlib.crc32(page[:PAGE_CRC_OFFSET]) & 0xFFFFFFFF != crc or PAGE_HEADER_LENGTH + length > PAGE_CRC_OFFSET:
+            bad += 1
+            continue
+        pages += 1
+        position = PAGE_HEADER_LENGTH
+        end = PAGE_HEADER_LENGTH + length
+        while position + RECORD_HEADER_LENGTH <= end:
+            record_type, record_length, ms = struct.unpack_from("<BBI", page, position)
+            position += RECORD_HEADER_LENGTH
+            records.append((sequence, ms, record_type, bytes(page[position:position + record_length])))
+            position += record_length
+    return pages, records, bad
+
+
+def encode_page(sequence, records):
+    body = b"".join(struct.pack("<BBI", t, len(d), ms) + d for ms, t, d in records)
+    page = struct.pack("<IH", sequence, len(body)) + body
+    page += b"\xff" * (PAGE_CRC_OFFSET - len(page))
+    return page + struct.pack("<I", zlib.crc32(page) & 0xFFFFFFFF)
+
+
+def check():
+    first = [(10, TYPE_BOOT, b"\x00"), (2500, TYPE_BUTTON, b"\x01\x01")]
+    second = [(4000, TYPE_DROPPED, struct.pack("<I", 3)), (4100, TYPE_CONNECTION_CLOSED, b"\x00\x13\x02")]
+    torn = bytearray(encode_page(8, second))
+    torn[20] ^= 0xFF
+    readout = encode_page(6, first) + bytes(torn) + encode_page(9, second)
+    pages, records, bad = decode(readout)
+    if pages != 2 or bad != 1:
+        print("FAIL: %d pages, %d bad" % (pages, bad))
+        return 1
+    expected = [(6, ms, t, d) for ms, t, d in first] + [(9, ms, t, d) for ms, t, d in second]
+    if records != expected:
+        print("FAIL: records differ")
+        return 1
+    if describe(TYPE_CONNECTION_CLOSED, b"\x00\x13\x02") != "connection 0 closed, reason 0x0213":
+        print("FAIL: description")
+        return 1
+    print("OK")
+    return 0
+
+
+def main(argv):
+    if not argv:
+        print("usage: event_log.py <read out> | --check")
+        return 2
+    if argv[0] == "--check":
+        return check()
+    with open(argv[0], "rb") as f:
+        pages, records, bad = decode(f.read())
+    for sequence, ms, record_type, data in records:
+        print("%8d %10.3f  %s" % (sequence, ms / 1000.0, describe(record_type, data)))
+    print("%d pages, %d records, %d bad pages" % (pages, len(records), bad))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
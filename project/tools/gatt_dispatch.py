@@ -0,0 +1,163 @@
+#!/usr/bin/env python3
+#
+# gatt_dispatch.py
+# Generates the handle indexed table of user characteristic handlers from
+# gatt.xml and the handles in gatt_db.h, see gatt_dispatch.h.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# Usage:
+#   gatt_dispatch.py <gatt.xml> <gatt_db.h> <table .c> <table .h>   generate the table
+#   gatt_dispatch.py --check                                        check generation of a sample database
+
+import os
+import re
+import sys
+import xml.etree.ElementTree as ElementTree
+
+GENERATED = """/********************************************************************
+ * Generated by tools/gatt_dispatch.py from gatt.xml, do not edit.
+ *******************************************************************/
+"""
+
+READ_PROPERTIES = ("read",)
+WRITE_PROPERTIES = ("write", "write_no_response", "reliable_write")
+# Write handlers take a uint8 length
+MAX_WRITE_LENGTH = 255
+
+
+class Characteristic(object):
+    def __init__(self, identifier, handle, length, read, write):
+        self.identifier = identifier
+        self.handle = handle
+        self.length = length
+        self.read = read
+        self.write = write
+
+    def handler(self, kind):
+        return "gattUser_%s%s" % ("".join(part.capitalize() for part in self.identifier.split("_")), kind)
+
+
+def parse_handles(header):
+    return {m.group(1): int(m.group(2)) for m in re.finditer(r"#define\s+gattdb_(\w+)\s+(\d+)", header)}
+
+
+def parse(xml, header):
+    """Returns the user characteristics, in handle order."""
+    handles = parse_handles(header)
+    characteristics = []
+    for element in ElementTree.fromstring(xml).iter("characteristic"):
+        value = element.find("value")
+        if value is None or value.get("type") != "user":
+            continue
+        identifier = element.get("id")
+        if identifier is None:
+            raise ValueError("user characteristic %s has no id" % element.get("name"))
+        if identifier not in handles:
+            raise ValueError("%s is not in gatt_db.h, regenerate it first" % identifier)
+        properties = element.find("properties")
+        properties = properties.attrib if properties is not None else {}
+        read = any(properties.get(p) == "true" for p in READ_PROPERTIES)
+        write = any(properties.get(p) == "true" for p in WRITE_PROPERTIES)
+        length = int(value.get("length", "0"))
+        if write and length > MAX_WRITE_LENGTH:
+            raise ValueError("%s is longer than the %d bytes a write handler takes" % (identifier, MAX_WRITE_LENGTH))
+        characteristics.append(Characteristic(identifier, handles[identifier], length, read, write))
+    characteristics.sort(key=lambda c: c.handle)
+    return characteristics
+
+
+def generate(characteristics, header_name):
+    """Returns the (.c, .h) source."""
+    guard = re.sub(r"\W", "_", os.path.basename(header_name)).upper()
+    first = characteristics[0].handle if characteristics else 0
+    count = characteristics[-1].handle - first + 1 if characteristics else 1
+    h = [GENERATED, "#ifndef %s" % guard, "#define %s" % guard, "", '#include "gatt_dispatch.h"', "",
+         "#define GATT_HANDLERS_FIRST %d" % first,
+         "#define GATT_HANDLERS_COUNT %d" % count, "",
+         "extern const GattUserHandler gattHandlers[GATT_HANDLERS_COUNT];", ""]
+    c = [GENERATED, '#include "%s"' % os.path.basename(header_name), '#include "gatt_db.h"', "",
+         "const GattUserHandler gattHandlers[GATT_HANDLERS_COUNT] = {"]
+    for ch in characteristics:
+        h.append("/* %s */" % ch.identifier)
+        if ch.read:
+            h.append("void %s(uint8 connection, uint16 offset) __attribute__((weak));" % ch.handler("Read"))
+        if ch.write:
+            h.append("uint8 %s(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));" % ch.handler("Write"))
+        c.append("\t[gattdb_%s - GATT_HANDLERS_FIRST] = { %s, %s, %d }," % (ch.identifier,
+                 ch.handler("Read") if ch.read else "NULL", ch.handler("Write") if ch.write else "NULL", ch.length))
+    h += ["", "#endif", ""]
+    c += ["};", ""]
+    return "\n".join(c), "\n".join(h)
+
+
+def check():
+    xml = """<gatt><service>
+      <characteristic id="device_name"><value length="13" type="utf-8"/><properties read="true" write="true"/></characteristic>
+      <characteristic id="ota_control"><value length="1" type="user"/><properties write="true"/></characteristic>
+      <characteristic id="stream"><value length="244" type="user" variable_length="true"/><properties write_no_response="true" notify="true"/></characteristic>
+      <characteristic id="press_count"><value length="4" type="user"/><properties read="true" write="true"/></characteristic>
+    </service></gatt>"""
+    header = """#define gattdb_device_name 7
+#define gattdb_ota_control 19
+#define gattdb_press_count 35
+#define gattdb_stream 22
+"""
+    characteristics = parse(xml, header)
+    if [(c.identifier, c.handle, c.length, c.read, c.write) for c in characteristics] != \
+            [("ota_control", 19, 1, False, True), ("stream", 22, 244, False, True), ("press_count", 35, 4, True, True)]:
+        print("FAIL: parse")
+        return 1
+    source, header_source = generate(characteristics, "gatt_handlers.h")
+    expected = ["#define GATT_HANDLERS_FIRST 19", "#define GATT_HANDLERS_COUNT 17",
+                "uint8 gattUser_PressCountWrite(uint8 connection, uint8 len, const uint8 *data) __attribute__((weak));"]
+    if any(line not in header_source.splitlines() for line in expected) or "#ifndef GATT_HANDLERS_H" not in header_source:
+        print("FAIL: header")
+        return 1
+    if "\t[gattdb_press_count - GATT_HANDLERS_FIRST] = { gattUser_PressCountRead, gattUser_PressCountWrite, 4 }," not in source.splitlines() \
+            or "gattUser_DeviceName" in source:
+        print("FAIL: table")
+        return 1
+    try:
+        parse(xml, "#define gattdb_ota_control 19\n")
+        print("FAIL: missing handle accepted")
+        return 1
+    except ValueError:
+        pass
+    try:
+        parse(xml.replace('length="4"', 'length="300"'), header)
+        print("FAIL: write longer than a handler takes accepted")
+        return 1
+    except ValueError:
+        pass
+    print("OK")
+    return 0
+
+
+def main(argv):
+    if argv[:1] == ["--check"]:
+        return check()
+    if len(argv) != 4:
+        print("usage: gatt_dispatch.py <gatt.xml> <gatt_db.h> <table .c> <table .h> | --check")
+        return 2
+    with open(argv[0]) as f:
+        xml = f.read()
+    with open(argv[1]) as f:
+        header = f.read()
+    try:
+        characteristics = parse(xml, header)
+    except ValueError as e:
+        print("Error: %s" % e)
+        return 1
+    source, header_source = generate(characteristics, argv[3])
+    with open(argv[2], "w") as f:
+        f.write(source)
+    with open(argv[3], "w") as f:
+        f.write(header_source)
+    print("%d user characteristics, handles %d to %d" % (len(characteristics),
+          characteristics[0].handle if characteristics else 0, characteristics[-1].handle if characteristics else 0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
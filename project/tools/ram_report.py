@@ -0,0 +1,115 @@
+#!/usr/bin/env python3
+#
+# ram_report.py
+# Lists the code and tables placed in RAM, see ram_code.h.
+#
+# (C) Copyright 2017 Nick Brook, https://www.nickbrook.me
+#
+# Usage:
+#   ram_report.py [--nm <nm>] <.axf or .out>   print what was placed and its size
+#   ram_report.py --check                      check the report of generated nm output
+#
+# GCC builds mark the placement with __ram_code_start__ and __ram_code_end__,
+# so functions and tables are listed. IAR builds have no such symbols, so every
+# function in RAM is listed and tables are only shown in the IAR map file
+# under .ram_table.
+
+import subprocess
+import sys
+
+RAM_START = 0x20000000
+RAM_END = 0x40000000
+CODE_TYPES = "Tt"
+
+
+def parse(nm_output):
+    """Returns a list of (address, size, type, name) from nm --print-size output."""
+    symbols = []
+    for line in nm_output.splitlines():
+        fields = line.split()
+        if len(fields) == 4:
+            address, size, symbol_type, name = fields
+            size = int(size, 16)
+        elif len(fields) == 3:
+            address, symbol_type, name = fields
+            size = 0
+        else:
+            continue
+        address = int(address, 16)
+        if symbol_type in CODE_TYPES:
+            # Thumb functions have bit 0 set
+            address &= ~1
+        symbols.append((address, size, symbol_type, name))
+    return symbols
+
+
+def placed(symbols):
+    """Returns (symbols placed in RAM, total bytes placed)."""
+    bounds = {name: address for address, size, symbol_type, name in symbols}
+    start = bounds.get("__ram_code_start__")
+    end = bounds.get("__ram_code_end__")
+    if start is not None and end is not None:
+        found = [s for s in symbols if start <= s[0] < end and s[1] > 0]
+        total = end - start
+    else:
+        found = [s for s in symbols if RAM_START <= s[0] < RAM_END and s[2] in CODE_TYPES and s[1] > 0]
+        total = sum(s[1] for s in found)
+    found.sort()
+    return found, total
+
+
+def report(symbols):
+    found, total = placed(symbols)
+    lines = ["%08x %6d %s %s" % s for s in found]
+    lines.append("%d symbols, %d bytes of RAM" % (len(found), total))
+    return "\n".join(lines)
+
+
+def check():
+    gcc = """0000a100 00000040 T main
+20003000 00000004 D displayReady
+20003004 D __ram_code_start__
+20003005 00000074 T GPIO_ODD_IRQHandler
+20003079 00000074 T GPIO_EVEN_IRQHandler
+200030ec 00000010 r portTable
+200030fc D __ram_code_end__
+20003100 00000100 B buffer
+"""
+    found, total = placed(parse(gcc))
+    names = [s[3] for s in found]
+    if names != ["GPIO_ODD_IRQHandler", "GPIO_EVEN_IRQHandler", "portTable"] or total != 0xF8:
+        print("FAIL: GCC placement %s, %d bytes" % (names, total))
+        return 1
+    if found[0][0] != 0x20003004:
+        print("FAIL: Thumb bit not masked")
+        return 1
+    iar = """0000a101 00000040 T main
+20003001 00000200 T gecko_evt_handle
+20003200 00000004 D displayReady
+"""
+    found, total = placed(parse(iar))
+    if [s[3] for s in found] != ["gecko_evt_handle"] or total != 0x200:
+        print("FAIL: IAR placement")
+        return 1
+    print("OK")
+    return 0
+
+
+def main(argv):
+    nm = "arm-none-eabi-nm"
+    if argv[:1] == ["--nm"] and len(argv) > 1:
+        nm = argv[1]
+        argv = argv[2:]
+    if not argv:
+        print("usage: ram_report.py [--nm <nm>] <.axf or .out> | --check")
+        return 2
+    if argv[0] == "--check":
+        return check()
+    output = subprocess.run([nm, "--print-size", "--defined-only", argv[0]],
+                            stdout=subprocess.PIPE, universal_newlines=True, check=True).stdout
+    print(report(parse(output)))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,542 @@
+/*****************************************************************************
+ * @file upgrade.c
+ * @brief In-application firmware upgrade into the SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "upgrade.h"
+#include "util.h"
+#include "board_features.h"
+#include "native_gecko.h"
+
+#ifdef FEATURE_SPI_FLASH
+
+#include <string.h>
+#include "gatt_db.h"
+#include "app_timer.h"
+#include "spi_flash.h"
+#include "delta.h"
+#include "crc.h"
+#include "btl_interface.h"
+#include "logging.h"
+
+#if (UPGRADE_DELTA_INPUT_SIZE & (UPGRADE_DELTA_INPUT_SIZE - 1)) != 0
+#error UPGRADE_DELTA_INPUT_SIZE must be a power of two
+#endif
+
+#define NO_SLOT 0xFF
+#define POLL_TICKS TIMER_MS_2_TIMERTICK(1)
+#define SLOT_ADDRESS(slot) (SPI_FLASH_IMAGE_SLOT_ADDRESS + (slot) * SPI_FLASH_IMAGE_SLOT_SIZE)
+/* PS key record: <uint8 slot> <uint32 size> <uint32 image crc32> <uint32 record crc32> */
+#define RECORD_SIZE 13
+/* Pending record: <record> <uint32 build id of the image it replaces> */
+#define PENDING_SIZE (RECORD_SIZE + 4)
+
+#if defined(__ICCARM__)
+#pragma section = "app"
+#else
+extern const char __text_start__[], __etext[], __data_start__[], __data_end__[];
+#endif
+
+typedef enum {
+	UpgradeStateIdle = 0,
+	UpgradeStateReceiving,
+	UpgradeStateVerifying,
+	UpgradeStateVerified,
+	UpgradeStateInstall,
+} UpgradeState;
+
+static UpgradeState state;
+static bool isDelta;
+static uint8 connection = NO_CONNECTION;
+static uint8 notifyConnection = NO_CONNECTION;
+/* Slot holding the running image, NO_SLOT if unknown, and its size and CRC */
+static uint8 sourceSlot;
+static uint32 sourceSize;
+static uint32 sourceCrc;
+static uint8 targetSlot;
+/* Target image size, the slot size for a delta until its header arrives */
+static uint32 size;
+static uint32 expectedCrc;
+/* Bytes received over the air, and expected */
+static uint32 received;
+static uint32 uploadSize;
+/* Acknowledged upload bytes at the last progress notification */
+static uint32 reported;
+static bool pollScheduled;
+
+static uint8 staging[UPGRADE_STAGING_PAGES][SPI_FLASH_PAGE_SIZE];
+/* Programs the target slot, its address and limit are set on start */
+static SpiFlashWriter writer = {
+	.regionPages = SPI_FLASH_IMAGE_SLOT_SIZE / SPI_FLASH_PAGE_SIZE,
+	.eraseAhead = UPGRADE_ERASE_AHEAD / SPI_FLASH_PAGE_SIZE,
+	.pages = staging,
+	.pageCount = UPGRADE_STAGING_PAGES,
+};
+/* Bytes in the buffer being filled */
+static uint16 fillLength;
+
+/* Delta input ring, head and tail run freely */
+static uint8 input[UPGRADE_DELTA_INPUT_SIZE];
+static uint32 inputHead;
+static uint32 inputTail;
+static DeltaDecoder decoder;
+
+static uint32 crc;
+static uint32 verified;
+
+static void loadRecord(void) {
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(UPGRADE_PS_KEY);
+	sourceSlot = NO_SLOT;
+	if (rsp->result == bg_err_success && rsp->value.len == RECORD_SIZE && rsp->value.data[0] < SPI_FLASH_IMAGE_SLOTS
+			&& crc_Crc32(0, rsp->value.data, RECORD_SIZE - 4) == getUint32(&rsp->value.data[RECORD_SIZE - 4])) {
+		sourceSlot = rsp->value.data[0];
+		sourceSize = getUint32(&rsp->value.data[1]);
+		sourceCrc = getUint32(&rsp->value.data[5]);
+	}
+}
+
+/* Identifies the running application, to tell after a reboot whether it was
+ * replaced. It covers the code and the initial data, so it changes with every
+ * build of the application, whichever files were rebuilt. */
+static uint32 buildId(void) {
+#if defined(__ICCARM__)
+	const uint8 *start = __section_begin("app");
+	return crc_Crc32(0, start, (const uint8 *) __section_end("app") - start);
+#else
+	uint32 id = crc_Crc32(0, __text_start__, __etext - __text_start__);
+	/* The initial data is stored after the code */
+	return crc_Crc32(id, __etext, __data_end__ - __data_start__);
+#endif
+}
+
+/* Kept until the installed image has booted, see upgrade_Init() */
+static void savePendingRecord(void) {
+	uint8 record[PENDING_SIZE];
+	record[0] = targetSlot;
+	putUint32(&record[1], size);
+	putUint32(&record[5], expectedCrc);
+	putUint32(&record[9], crc_Crc32(0, record, RECORD_SIZE - 4));
+	putUint32(&record[RECORD_SIZE], buildId());
+	gecko_cmd_flash_ps_save(UPGRADE_PENDING_PS_KEY, sizeof(record), record);
+}
+
+/* Target bytes programmed into the flash. The last page is programmed whole, so may run past the end. */
+static uint32 programmed(void) {
+	return MIN(writer.written * SPI_FLASH_PAGE_SIZE, size);
+}
+
+/* Stop erasing at the end of the target image */
+static void setSize(uint32 value) {
+	size = value;
+	writer.limit = (size + SPI_FLASH_PAGE_SIZE - 1) / SPI_FLASH_PAGE_SIZE;
+}
+
+/* Upload bytes the client may forget about */
+static uint32 acknowledged(void) {
+	return isDelta ? inputTail : programmed();
+}
+
+static void notifyStatus(UpgradeStatus status) {
+	if (notifyConnection == NO_CONNECTION) {
+		return;
+	}
+	uint8 report[5];
+	report[0] = status;
+	putUint32(&report[1], acknowledged());
+	gecko_cmd_gatt_server_send_characteristic_notification(notifyConnection, gattdb_image_control, sizeof(report), report);
+}
+
+static void reportProgress(void) {
+	uint32 ack = acknowledged();
+	bool idle = ack == received;
+	if (ack - reported >= SPI_FLASH_PAGE_SIZE || (ack != reported && idle)) {
+		reported = ack;
+		notifyStatus(UpgradeStatusProgress);
+	}
+}
+
+static void schedulePoll(void) {
+	if (!pollScheduled) {
+		pollScheduled = true;
+		gecko_cmd_hardware_set_soft_timer(POLL_TICKS, AppTimerIDUpgrade, true);
+	}
+}
+
+static void stop(UpgradeStatus status) {
+	if (state == UpgradeStateReceiving || state == UpgradeStateVerifying) {
+		spiFlash_Release();
+	}
+	LogInfo("Upgrade stopped: 0x%x", status);
+	state = UpgradeStateIdle;
+	connection = NO_CONNECTION;
+	notifyStatus(status);
+}
+
+static void queueFillPage(void) {
+	spiFlash_WriterQueue(&writer);
+	fillLength = 0;
+}
+
+static uint16 stageSpace(void) {
+	return (UPGRADE_STAGING_PAGES - writer.pagesQueued) * SPI_FLASH_PAGE_SIZE - fillLength;
+}
+
+/* Copy into the staging buffers, at most stageSpace() bytes */
+static void stageWrite(const uint8 *data, uint16 len) {
+	while (len > 0) {
+		uint16 chunk = MIN(len, SPI_FLASH_PAGE_SIZE - fillLength);
+		memcpy(&staging[writer.fillPage][fillLength], data, chunk);
+		fillLength += chunk;
+		data += chunk;
+		len -= chunk;
+		if (fillLength == SPI_FLASH_PAGE_SIZE) {
+			queueFillPage();
+		}
+	}
+}
+
+static void readSource(uint32 offset, uint8 *data, uint16 len) {
+	spiFlash_Read(SLOT_ADDRESS(sourceSlot) + offset, data, len);
+}
+
+/* Earlier target bytes are in the flash, or still in the staging buffers */
+static void readTarget(uint32 offset, uint8 *data, uint16 len) {
+	uint32 flashed = programmed();
+	if (offset < flashed) {
+		uint16 n = MIN(len, flashed - offset);
+		spiFlash_Read(SLOT_ADDRESS(targetSlot) + offset, data, n);
+		offset += n;
+		data += n;
+		len -= n;
+	}
+	while (len > 0) {
+		uint32 index = offset - flashed;
+		uint8 page = (writer.programPage + index / SPI_FLASH_PAGE_SIZE) % UPGRADE_STAGING_PAGES;
+		uint16 pageOffset = index % SPI_FLASH_PAGE_SIZE;
+		uint16 n = MIN(len, SPI_FLASH_PAGE_SIZE - pageOffset);
+		memcpy(data, &staging[page][pageOffset], n);
+		offset += n;
+		data += n;
+		len -= n;
+	}
+}
+
+static const DeltaIO deltaIO = { stageSpace, stageWrite, readSource, readTarget };
+
+/* Feed buffered delta input to the decoder, returns false if the delta is bad */
+static bool decodeInput(void) {
+	while (decoder.status == DeltaStatusOK) {
+		bool headerDone = delta_HeaderDone(&decoder);
+		uint32 offset = inputTail & (UPGRADE_DELTA_INPUT_SIZE - 1);
+		uint32 len = MIN(inputHead - inputTail, UPGRADE_DELTA_INPUT_SIZE - offset);
+		uint32 consumed = delta_Decode(&decoder, &deltaIO, &input[offset], len);
+		inputTail += consumed;
+		if (!headerDone && delta_HeaderDone(&decoder) && decoder.status == DeltaStatusOK) {
+			if (decoder.sourceSize != sourceSize || decoder.sourceCrc != sourceCrc) {
+				stop(UpgradeStatusReferenceMismatch);
+				return true;
+			}
+			if (decoder.targetSize == 0 || decoder.targetSize > SPI_FLASH_IMAGE_SLOT_SIZE) {
+				return false;
+			}
+			setSize(decoder.targetSize);
+			expectedCrc = decoder.targetCrc;
+			continue;
+		}
+		if (consumed < len || len == 0) {
+			break;
+		}
+	}
+	return decoder.status == DeltaStatusOK || decoder.status == DeltaStatusDone;
+}
+
+/* True once every target byte is in the staging buffers or the flash */
+static bool targetComplete(void) {
+	return isDelta ? decoder.status == DeltaStatusDone : received == size;
+}
+
+static void verifyChunk(void) {
+	/* Static, as a chunk is too big for the stack of an event handler */
+	static uint8 buffer[UPGRADE_VERIFY_CHUNK];
+	uint32 len = MIN(UPGRADE_VERIFY_CHUNK, size - verified);
+	spiFlash_Read(SLOT_ADDRESS(targetSlot) + verified, buffer, len);
+	crc = crc_Crc32(crc, buffer, len);
+	verified += len;
+	if (verified < size) {
+		schedulePoll();
+		return;
+	}
+	if (crc != expectedCrc) {
+		stop(UpgradeStatusCrcMismatch);
+		return;
+	}
+	/* The bootloader parses the GBL file, checking its own CRC and signature if enabled */
+	if (bootloader_verifyImage(targetSlot, NULL) != BOOTLOADER_OK || bootloader_setImageToBootload(targetSlot) != BOOTLOADER_OK) {
+		stop(UpgradeStatusInvalidImage);
+		return;
+	}
+	spiFlash_Release();
+	state = UpgradeStateVerified;
+	LogInfo("Upgrade image verified in slot %d", targetSlot);
+	notifyStatus(UpgradeStatusVerified);
+}
+
+static void receive(void) {
+	bool busy = spiFlash_WriterPump(&writer);
+	/* The decoder reads the flash back, which would wait out a program or
+	 * erase, so it only runs while the flash is idle */
+	if (isDelta && !busy) {
+		if (!decodeInput()) {
+			stop(UpgradeStatusBadDelta);
+			return;
+		}
+		if (state != UpgradeStateReceiving) {
+			return;
+		}
+	}
+	if (targetComplete() && fillLength > 0) {
+		queueFillPage();
+	}
+	if (!busy) {
+		busy = spiFlash_WriterPump(&writer);
+	}
+	reportProgress();
+	if (busy) {
+		schedulePoll();
+	} else if (isDelta && !targetComplete() && received == uploadSize && inputTail == inputHead) {
+		/* Everything has arrived and been decoded, but the target is short */
+		stop(UpgradeStatusBadDelta);
+	} else if (targetComplete() && programmed() == size) {
+		state = UpgradeStateVerifying;
+		crc = 0;
+		verified = 0;
+		verifyChunk();
+	}
+}
+
+void upgrade_Poll(void) {
+	pollScheduled = false;
+	switch (state) {
+	case UpgradeStateReceiving:
+		receive();
+		break;
+	case UpgradeStateVerifying:
+		verifyChunk();
+		break;
+	default:
+		break;
+	}
+}
+
+static void start(uint8 conn, bool delta) {
+	bootloader_init();
+	spiFlash_Acquire();
+	state = UpgradeStateReceiving;
+	isDelta = delta;
+	connection = conn;
+	/* Never overwrite the running image, a delta needs it and a failed upgrade falls back to it */
+	targetSlot = sourceSlot == NO_SLOT ? 0 : (sourceSlot + 1) % SPI_FLASH_IMAGE_SLOTS;
+	received = 0;
+	reported = 0;
+	writer.address = SLOT_ADDRESS(targetSlot);
+	spiFlash_WriterReset(&writer, 0, 0);
+	fillLength = 0;
+	inputHead = 0;
+	inputTail = 0;
+	delta_Init(&decoder);
+	LogInfo("Upgrade started into slot %d, %lu bytes%s", targetSlot, uploadSize, delta ? " of delta" : "");
+	upgrade_Poll();
+}
+
+uint8 upgrade_ControlWrite(uint8 conn, uint8 len, const uint8 *data) {
+	if (len < 1) {
+		return (uint8) bg_err_att_invalid_att_length;
+	}
+	switch ((UpgradeCommand) data[0]) {
+	case UpgradeCommandStart:
+		if (len < 9) {
+			return (uint8) bg_err_att_invalid_att_length;
+		}
+		if (state == UpgradeStateReceiving || state == UpgradeStateVerifying) {
+			stop(UpgradeStatusAborted);
+		}
+		uint32 imageSize = getUint32(&data[1]);
+		if (imageSize == 0 || imageSize > SPI_FLASH_IMAGE_SLOT_SIZE) {
+			return (uint8) bg_err_att_invalid_att_length;
+		}
+		setSize(imageSize);
+		expectedCrc = getUint32(&data[5]);
+		loadRecord();
+		uploadSize = size;
+		start(conn, false);
+		break;
+	case UpgradeCommandStartDelta:
+		if (len < 5) {
+			return (uint8) bg_err_att_invalid_att_length;
+		}
+		if (state == UpgradeStateReceiving || state == UpgradeStateVerifying) {
+			stop(UpgradeStatusAborted);
+		}
+		loadRecord();
+		if (sourceSlot == NO_SLOT) {
+			/* The flash does not hold a known image to patch */
+			notifyStatus(UpgradeStatusReferenceMismatch);
+			return (uint8) bg_err_att_request_not_supported;
+		}
+		uploadSize = getUint32(&data[1]);
+		/* Known once the delta header arrives */
+		setSize(SPI_FLASH_IMAGE_SLOT_SIZE);
+		expectedCrc = 0;
+		start(conn, true);
+		break;
+	case UpgradeCommandAbort:
+		if (state != UpgradeStateIdle) {
+			stop(UpgradeStatusAborted);
+		}
+		break;
+	case UpgradeCommandInstall:
+		if (state != UpgradeStateVerified) {
+			return (uint8) bg_err_att_request_not_supported;
+		}
+		/* Reboot once the client has gone */
+		state = UpgradeStateInstall;
+		gecko_cmd_endpoint_close(conn);
+		break;
+	default:
+		return (uint8) bg_err_att_request_not_supported;
+	}
+	return bg_err_success;
+}
+
+void upgrade_DataWrite(uint8 conn, uint8 len, const uint8 *data) {
+	if (state != UpgradeStateReceiving || conn != connection) {
+		return;
+	}
+	if (received + len > uploadSize) {
+		stop(UpgradeStatusOverrun);
+		return;
+	}
+	if (isDelta) {
+		if (len > UPGRADE_DELTA_INPUT_SIZE - (inputHead - inputTail)) {
+			stop(UpgradeStatusOverrun);
+			return;
+		}
+		for (uint8 i = 0; i < len; i++) {
+			input[(inputHead + i) & (UPGRADE_DELTA_INPUT_SIZE - 1)] = data[i];
+		}
+		inputHead += len;
+	} else {
+		if (len > stageSpace()) {
+			/* The client sent more than the acknowledged window */
+			stop(UpgradeStatusOverrun);
+			return;
+		}
+		stageWrite(data, len);
+	}
+	received += len;
+	/* Flash work and decoding happen from the poll timer, never in this handler */
+	schedulePoll();
+}
+
+bool upgrade_InstallPending(void) {
+	return state == UpgradeStateInstall;
+}
+
+void upgrade_Init(void) {
+	struct gecko_msg_flash_ps_load_rsp_t *rsp = gecko_cmd_flash_ps_load(UPGRADE_PENDING_PS_KEY);
+	if (rsp->result != bg_err_success) {
+		return;
+	}
+	/* Copied, as the response is overwritten by the next command */
+	uint8 record[PENDING_SIZE];
+	memcpy(record, rsp->value.data, MIN(rsp->value.len, sizeof(record)));
+	if (rsp->value.len == PENDING_SIZE && crc_Crc32(0, record, RECORD_SIZE - 4) == getUint32(&record[RECORD_SIZE - 4])) {
+		if (getUint32(&record[RECORD_SIZE]) != buildId()) {
+			/* The new image is running, so it is the reference for the next delta */
+			LogInfo("Upgrade from slot %d installed", record[0]);
+			gecko_cmd_flash_ps_save(UPGRADE_PS_KEY, RECORD_SIZE, record);
+		} else {
+			LogWarn("Upgrade from slot %d did not install", record[0]);
+		}
+	}
+	gecko_cmd_flash_ps_erase(UPGRADE_PENDING_PS_KEY);
+}
+
+void upgrade_Install(void) {
+	LogInfo("Installing upgrade");
+	savePendingRecord();
+	bootloader_rebootAndInstall();
+}
+
+void upgrade_ConnectionClosed(uint8 conn) {
+	if (conn == notifyConnection) {
+		notifyConnection = NO_CONNECTION;
+	}
+	if (conn == connection && (state == UpgradeStateReceiving || state == UpgradeStateVerifying)) {
+		stop(UpgradeStatusAborted);
+	}
+}
+
+void upgrade_CharacteristicStatus(uint8 conn, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+	if (characteristic == gattdb_image_control && status_flags == gatt_server_client_config) {
+		notifyConnection = (client_config_flags & gatt_notification) ? conn : NO_CONNECTION;
+	}
+}
+
+#else
+
+void upgrade_Init(void) {
+}
+
+uint8 upgrade_ControlWrite(uint8 connection, uint8 len, const uint8 *data) {
+	return (uint8) bg_err_att_request_not_supported;
+}
+
+void upgrade_DataWrite(uint8 connection, uint8 len, const uint8 *data) {
+}
+
+void upgrade_Poll(void) {
+}
+
+bool upgrade_InstallPending(void) {
+	return false;
+}
+
+void upgrade_Install(void) {
+}
+
+void upgrade_ConnectionClosed(uint8 connection) {
+}
+
+void upgrade_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags) {
+}
+
+#endif /* FEATURE_SPI_FLASH */
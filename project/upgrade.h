@@ -0,0 +1,163 @@
+/*****************************************************************************
+ * @file upgrade.h
+ * @brief In-application firmware upgrade into the SPI flash
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef UPGRADE_H_
+#define UPGRADE_H_
+
+#include "bg_types.h"
+
+/* The device keeps running while a GBL upgrade image is received into a
+ * bootloader storage slot in the SPI flash. It only reboots once, into the
+ * verified image, instead of rebooting into the OTA bootloader for the whole
+ * transfer. Images go into the slot that does not hold the running image,
+ * which is recorded in a PS key once an installed image has booted.
+ *
+ * Image data is written without response into a ring of page sized RAM
+ * staging buffers. Full pages are programmed in the background while the next
+ * page fills, and sectors are erased ahead of the programmed data. Progress
+ * notifications acknowledge upload bytes; the client must keep no more than
+ * the window (UPGRADE_STAGING_PAGES pages for an image, UPGRADE_DELTA_INPUT_SIZE
+ * for a delta) beyond the last acknowledged byte count in flight.
+ *
+ * A delta image (see delta.h) is decoded on the fly against the running
+ * image, which must be the reference the delta was made from.
+ *
+ * Writing to the image control characteristic:
+ *   0x01 <uint32 size> <uint32 crc32> - start an upgrade with a full image
+ *   0x04 <uint32 delta size>          - start an upgrade with a delta image
+ *   0x02                              - abort
+ *   0x03                              - install, once verified. The device reboots when the connection closes.
+ * Status is notified on the image control characteristic as
+ *   <uint8 status> <uint32 bytes acknowledged>
+ * all little endian. Once all bytes are programmed the CRC-32 of the image is
+ * checked and the bootloader verifies it.
+ *
+ * The project is built for the Gecko bootloader, and create_bl_files.sh makes
+ * the GBL images; full.gbl is the image to upload. Only available on boards with
+ * FEATURE_SPI_FLASH, flashed with the SPI flash storage Gecko bootloader with two
+ * storage slots at SPI_FLASH_IMAGE_SLOT_ADDRESS. Other boards use the Bluetooth
+ * in-place OTA DFU Gecko bootloader through the ota_control characteristic.
+ */
+
+/** Number of page sized staging buffers. */
+#ifndef UPGRADE_STAGING_PAGES
+#define UPGRADE_STAGING_PAGES 2
+#endif
+
+/** How far ahead of the programmed data to erase, in bytes. */
+#ifndef UPGRADE_ERASE_AHEAD
+#define UPGRADE_ERASE_AHEAD 8192
+#endif
+
+/** Size of the delta input ring in bytes. Must be a power of two. */
+#ifndef UPGRADE_DELTA_INPUT_SIZE
+#define UPGRADE_DELTA_INPUT_SIZE 512
+#endif
+
+/** PS key recording the slot, size and CRC of the installed image. */
+#ifndef UPGRADE_PS_KEY
+#define UPGRADE_PS_KEY 0x4030
+#endif
+
+/** PS key holding the record of an image being installed until it boots. */
+#ifndef UPGRADE_PENDING_PS_KEY
+#define UPGRADE_PENDING_PS_KEY 0x4031
+#endif
+
+/** Bytes read back per turn of the event loop while verifying. */
+#ifndef UPGRADE_VERIFY_CHUNK
+#define UPGRADE_VERIFY_CHUNK 1024
+#endif
+
+typedef enum {
+	UpgradeCommandStart = 0x01,
+	UpgradeCommandAbort = 0x02,
+	UpgradeCommandInstall = 0x03,
+	UpgradeCommandStartDelta = 0x04,
+} UpgradeCommand;
+
+typedef enum {
+	UpgradeStatusProgress = 0x00,
+	UpgradeStatusVerified = 0x01,
+	UpgradeStatusAborted = 0x80,
+	UpgradeStatusOverrun = 0x81,
+	UpgradeStatusCrcMismatch = 0x82,
+	UpgradeStatusInvalidImage = 0x83,
+	UpgradeStatusBadDelta = 0x84,
+	UpgradeStatusReferenceMismatch = 0x85,
+} UpgradeStatus;
+
+/***************************************************************************//**
+ * @brief
+ *   Record the installed image once it has booted. Call from gecko_evt_system_boot().
+ ******************************************************************************/
+void upgrade_Init(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Handle a write to the image control characteristic.
+ *
+ * @return
+ *   The ATT error code for the write response.
+ ******************************************************************************/
+uint8 upgrade_ControlWrite(uint8 connection, uint8 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   Handle a write without response to the image data characteristic.
+ ******************************************************************************/
+void upgrade_DataWrite(uint8 connection, uint8 len, const uint8 *data);
+
+/***************************************************************************//**
+ * @brief
+ *   Progress programming and verification. Call when the AppTimerIDUpgrade timer fires.
+ ******************************************************************************/
+void upgrade_Poll(void);
+
+/***************************************************************************//**
+ * @brief
+ *   True if a verified image should be installed.
+ ******************************************************************************/
+bool upgrade_InstallPending(void);
+
+/***************************************************************************//**
+ * @brief
+ *   Reboot and install the verified image.
+ ******************************************************************************/
+void upgrade_Install(void);
+
+/* Event hooks, call from the matching gecko events */
+void upgrade_ConnectionClosed(uint8 connection);
+void upgrade_CharacteristicStatus(uint8 connection, uint16 characteristic, uint8 status_flags, uint16 client_config_flags);
+
+#endif /* UPGRADE_H_ */
@@ -0,0 +1,63 @@
+/*****************************************************************************
+ * @file util.h
+ * @brief Small helpers shared by the modules
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef UTIL_H_
+#define UTIL_H_
+
+#include "bg_types.h"
+
+/** The smaller of two values. Arguments are evaluated twice. */
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+
+/** Connection handle meaning no connection. */
+#define NO_CONNECTION 0xFF
+
+/* Little endian values in characteristics, records and PS keys */
+
+static inline void putUint16(uint8 *p, uint16 value) {
+	p[0] = value;
+	p[1] = value >> 8;
+}
+
+static inline void putUint32(uint8 *p, uint32 value) {
+	p[0] = value;
+	p[1] = value >> 8;
+	p[2] = value >> 16;
+	p[3] = value >> 24;
+}
+
+static inline uint32 getUint32(const uint8 *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32) p[3] << 24);
+}
+
+#endif /* UTIL_H_ */
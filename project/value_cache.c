@@ -0,0 +1,126 @@
+/*****************************************************************************
+ * @file value_cache.c
+ * @brief Cached values of user read characteristics
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "value_cache.h"
+#include <string.h>
+#include "native_gecko.h"
+#include "logging.h"
+
+typedef struct {
+	uint16 characteristic;
+	ValueCacheFill fill;
+	/* The value matches its source */
+	bool valid;
+	/* Holds a value, possibly stale, for the rest of a long read */
+	bool filled;
+	uint16 version;
+	uint8 length;
+	uint8 value[VALUE_CACHE_MAX_LENGTH];
+} ValueCacheEntry;
+
+static ValueCacheEntry entries[VALUE_CACHE_MAX_ENTRIES];
+static uint8 entryCount;
+
+static ValueCacheEntry *findEntry(uint16 characteristic) {
+	for (uint8 i = 0; i < entryCount; i++) {
+		if (entries[i].characteristic == characteristic) {
+			return &entries[i];
+		}
+	}
+	return NULL;
+}
+
+bool valueCache_Register(uint16 characteristic, ValueCacheFill fill) {
+	if (entryCount >= VALUE_CACHE_MAX_ENTRIES || findEntry(characteristic)) {
+		LogWarn("Could not cache characteristic %d", characteristic);
+		return false;
+	}
+	ValueCacheEntry *e = &entries[entryCount++];
+	memset(e, 0, sizeof(*e));
+	e->characteristic = characteristic;
+	e->fill = fill;
+	return true;
+}
+
+static void replaced(ValueCacheEntry *e) {
+	e->valid = true;
+	e->filled = true;
+	e->version++;
+}
+
+void valueCache_Publish(uint16 characteristic, const uint8 *value, uint8 len) {
+	ValueCacheEntry *e = findEntry(characteristic);
+	if (!e) {
+		return;
+	}
+	if (len > VALUE_CACHE_MAX_LENGTH) {
+		LogWarn("Value of characteristic %d cut to %d bytes", characteristic, VALUE_CACHE_MAX_LENGTH);
+		len = VALUE_CACHE_MAX_LENGTH;
+	}
+	memcpy(e->value, value, len);
+	e->length = len;
+	replaced(e);
+}
+
+void valueCache_Invalidate(uint16 characteristic) {
+	ValueCacheEntry *e = findEntry(characteristic);
+	if (e) {
+		e->valid = false;
+	}
+}
+
+uint16 valueCache_Version(uint16 characteristic) {
+	ValueCacheEntry *e = findEntry(characteristic);
+	return e ? e->version : 0;
+}
+
+bool valueCache_Read(uint8 connection, uint16 characteristic, uint16 offset) {
+	ValueCacheEntry *e = findEntry(characteristic);
+	if (!e) {
+		return false;
+	}
+	if (!e->valid && !e->fill) {
+		/* Left to the read handler until a value is published again */
+		return false;
+	}
+	if (!e->valid && (offset == 0 || !e->filled)) {
+		e->length = e->fill(e->value);
+		replaced(e);
+	}
+	if (offset > e->length) {
+		gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, (uint8) bg_err_att_invalid_offset, 0, NULL);
+		return true;
+	}
+	gecko_cmd_gatt_server_send_user_read_response(connection, characteristic, bg_err_success, e->length - offset, &e->value[offset]);
+	return true;
+}
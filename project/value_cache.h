@@ -0,0 +1,110 @@
+/*****************************************************************************
+ * @file value_cache.h
+ * @brief Cached values of user read characteristics
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef VALUE_CACHE_H_
+#define VALUE_CACHE_H_
+
+#include "bg_types.h"
+
+/* Values of user type characteristics that are costly to build are kept in
+ * fixed buffers and read requests are answered straight from them, at any
+ * offset, by gattDispatch_Read() before any read handler.
+ *
+ * A module either publishes a new value whenever its source changes, or
+ * registers a fill function and invalidates the value when its source changes,
+ * so the value is rebuilt by the next read that needs it. Each new value
+ * increments the entry version. A published value that is invalidated is left
+ * to the read handler until the next value is published.
+ *
+ * Only a read at offset 0 rebuilds an invalid value. The rest of a long read
+ * (read blob requests at later offsets) is served from the same value, so the
+ * client never sees parts of two different values unless one is published in
+ * between.
+ */
+
+/** Maximum number of cached characteristics. */
+#ifndef VALUE_CACHE_MAX_ENTRIES
+#define VALUE_CACHE_MAX_ENTRIES 4
+#endif
+
+/** Longest cached value. */
+#ifndef VALUE_CACHE_MAX_LENGTH
+#define VALUE_CACHE_MAX_LENGTH 32
+#endif
+
+/** Build the value into value, at most VALUE_CACHE_MAX_LENGTH bytes, and return its length. */
+typedef uint8 (*ValueCacheFill)(uint8 *value);
+
+/***************************************************************************//**
+ * @brief
+ *   Cache the value of a characteristic.
+ *
+ * @param[in] characteristic
+ *   The characteristic handle, from gatt_db.h.
+ *
+ * @param[in] fill
+ *   Builds the value when it is invalid, or NULL if it is only published.
+ *
+ * @return
+ *   False if there is no room for it.
+ ******************************************************************************/
+bool valueCache_Register(uint16 characteristic, ValueCacheFill fill);
+
+/***************************************************************************//**
+ * @brief
+ *   Replace the value of a registered characteristic.
+ ******************************************************************************/
+void valueCache_Publish(uint16 characteristic, const uint8 *value, uint8 len);
+
+/***************************************************************************//**
+ * @brief
+ *   Mark the value as changed, so it is filled again by the next read.
+ ******************************************************************************/
+void valueCache_Invalidate(uint16 characteristic);
+
+/***************************************************************************//**
+ * @brief
+ *   The version of the value, incremented each time it is replaced.
+ ******************************************************************************/
+uint16 valueCache_Version(uint16 characteristic);
+
+/***************************************************************************//**
+ * @brief
+ *   Answer a read request from the cache.
+ *
+ * @return
+ *   False if the characteristic is not cached, and the request was not answered.
+ ******************************************************************************/
+bool valueCache_Read(uint8 connection, uint16 characteristic, uint16 offset);
+
+#endif /* VALUE_CACHE_H_ */
@@ -0,0 +1,107 @@
+/*****************************************************************************
+ * @file work.c
+ * @brief Prioritised run to completion work queue
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#include "work.h"
+#include "em_device.h"
+#include "em_core.h"
+#include "em_rtcc.h"
+#include "native_gecko.h"
+#include "app_timer.h"
+#include "logging.h"
+
+/* FIFO per priority */
+static WorkItem *heads[WorkPriorityCount];
+static WorkItem *tails[WorkPriorityCount];
+
+bool work_Post(WorkItem *item) {
+	bool posted = false;
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_ATOMIC();
+	if (!item->pending) {
+		item->pending = true;
+		item->next = NULL;
+		item->postedAt = RTCC_CounterGet();
+		if (tails[item->priority]) {
+			tails[item->priority]->next = item;
+		} else {
+			heads[item->priority] = item;
+		}
+		tails[item->priority] = item;
+		posted = true;
+	}
+	CORE_EXIT_ATOMIC();
+	/* Events handled in the loop lead to a run anyway, interrupts have to wake it */
+	if (posted && __get_IPSR() != 0) {
+		gecko_external_signal(WORK_SIGNAL);
+	}
+	return posted;
+}
+
+bool work_Run(void) {
+	WorkItem *item = NULL;
+	CORE_DECLARE_IRQ_STATE;
+	CORE_ENTER_ATOMIC();
+	for (int i = 0; i < WorkPriorityCount && !item; i++) {
+		if (heads[i]) {
+			item = heads[i];
+			heads[i] = item->next;
+			if (!heads[i]) {
+				tails[i] = NULL;
+			}
+			/* It can be posted again while it runs */
+			item->pending = false;
+		}
+	}
+	CORE_EXIT_ATOMIC();
+	if (!item) {
+		return false;
+	}
+
+	uint32 start = RTCC_CounterGet();
+	uint32 latency = start - item->postedAt;
+	item->function();
+	uint32 run = RTCC_CounterGet() - start;
+
+	item->runs++;
+	if (run > item->maxRun) {
+		item->maxRun = run;
+	}
+	if (latency > item->maxLatency) {
+		item->maxLatency = latency;
+		if (latency > TIMER_MS_2_TIMERTICK(WORK_LATENCY_WARNING)) {
+			LogWarn("Work %s waited %lu ms", item->name, TIMER_TIMERTICK_2_MS(latency));
+		}
+	}
+	/* Check for events, then look again */
+	return true;
+}
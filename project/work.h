@@ -0,0 +1,109 @@
+/*****************************************************************************
+ * @file work.h
+ * @brief Prioritised run to completion work queue
+ * @author Nick Brook
+ * @version 1.00
+ ******************************************************************************
+ * @section License
+ * <b>(C) Copyright 2017 Nick Brook, https://www.nickbrook.me</b>
+ *******************************************************************************
+ *
+ * Permission is granted to anyone to use this software for any purpose,
+ * including commercial applications, and to alter it and redistribute it
+ * freely, subject to the following restrictions:
+ *
+ * 1. The origin of this software must not be misrepresented; you must not
+ *    claim that you wrote the original software.
+ * 2. Altered source versions must be plainly marked as such, and must not be
+ *    misrepresented as being the original software.
+ * 3. This notice may not be removed or altered from any source distribution.
+ *
+ * DISCLAIMER OF WARRANTY/LIMITATION OF REMEDIES: Nick Brook has no
+ * obligation to support this Software. Nick Brook is providing the
+ * Software "AS IS", with no express or implied warranties of any kind,
+ * including, but not limited to, any implied warranties of merchantability
+ * or fitness for any particular purpose or warranties against infringement
+ * of any proprietary rights of a third party.
+ *
+ * Nick Brook will not be liable for any consequential, incidental, or
+ * special damages, or any other relief, or for any claim by any third party,
+ * arising from your use of this Software.
+ *
+ ******************************************************************************/
+
+#ifndef WORK_H_
+#define WORK_H_
+
+#include "bg_types.h"
+
+/* Work that can wait, such as display redraws and storage, is posted as work
+ * items instead of being done in event handlers. The event loop only runs an
+ * item when the stack has no event waiting, one item per turn, highest
+ * priority first and in posting order within a priority, so Bluetooth events
+ * are never queued behind it. Items run to completion.
+ *
+ * Items are statically allocated by their owners. Posting an item that is
+ * already waiting does nothing, so repeated posts, e.g. one per button press,
+ * coalesce into one run. Items can be posted from interrupts, which raise
+ * WORK_SIGNAL to wake the event loop.
+ *
+ * Each item keeps the longest it has waited to run and the longest it has
+ * run, in RTCC ticks (TIMER_CLK_FREQ per second). Waits longer than
+ * WORK_LATENCY_WARNING ms are logged.
+ */
+
+/** Wait in ms beyond which a new longest wait is logged. */
+#ifndef WORK_LATENCY_WARNING
+#define WORK_LATENCY_WARNING 100
+#endif
+
+/** External signal raised by posts from interrupts. Must not overlap the GPIO signals. */
+#define WORK_SIGNAL 0x00040000
+
+typedef enum {
+	WorkPriorityHigh = 0,
+	WorkPriorityNormal,
+	WorkPriorityLow,
+	WorkPriorityCount,
+} WorkPriority;
+
+typedef void (*WorkFunction)(void);
+
+typedef struct WorkItem {
+	WorkFunction function;
+	/** Name used in the log */
+	const char *name;
+	WorkPriority priority;
+	/* Owned by work.c */
+	volatile bool pending;
+	struct WorkItem *next;
+	uint32 postedAt;
+	/** Longest wait from posting to running */
+	uint32 maxLatency;
+	/** Longest run */
+	uint32 maxRun;
+	uint32 runs;
+} WorkItem;
+
+/** Initialiser for a work item. */
+#define WORK_ITEM(function, name, priority) { (function), (name), (priority) }
+
+/***************************************************************************//**
+ * @brief
+ *   Queue an item to run when the event loop is idle. Safe from interrupts.
+ *
+ * @return
+ *   False if it was already waiting.
+ ******************************************************************************/
+bool work_Post(WorkItem *item);
+
+/***************************************************************************//**
+ * @brief
+ *   Run the highest priority waiting item. Call when no event is waiting.
+ *
+ * @return
+ *   True if an item was run, so more may be waiting.
+ ******************************************************************************/
+bool work_Run(void);
+
+#endif /* WORK_H_ */